@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/delaunay.h"
+
+// benchmark of the incremental delaunay triangulation and of the face -> node index of the history graph
+// usage: benchmarks [number of points] [repetitions]
+
+namespace {
+    std::vector<util::point> uniform_points(int n)
+    {
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> distribution(0, 1000);
+        std::vector<util::point> points;
+        points.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            points.emplace_back(distribution(generator), distribution(generator));
+        }
+        return points;
+    }
+
+    // uniform points on an integer grid, predicates are evaluated in integers
+    std::vector<util::point> grid_points(int n)
+    {
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<int> distribution(0, 1 << 20);
+        std::vector<util::point> points;
+        points.reserve(n);
+        for (int i = 0; i < n; ++i) {
+            points.emplace_back(distribution(generator), distribution(generator));
+        }
+        return points;
+    }
+
+    // uniform points sorted by x coordinate in input order, every new point is
+    // on the right side of the hull and many edges have to be flipped,
+    // the history graph is deep for this order, so fewer points are used
+    std::vector<util::point> sorted_points(int n)
+    {
+        auto points = uniform_points(n);
+        std::sort(points.begin(), points.end(), [](util::point lhs, util::point rhs) { return lhs.x() < rhs.x(); });
+        return points;
+    }
+
+    void run(const std::string& name, const std::vector<util::point>& points, delaunaytype::options options, int repetitions)
+    {
+        double best = 0;
+        long long flips = 0;
+        for (int i = 0; i < repetitions; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            delaunay del{points, options};
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (i == 0 || elapsed.count() < best) {
+                best = elapsed.count();
+            }
+            flips = del.statistics().flips;
+        }
+
+        std::cout << std::left << std::setw(24) << name 
+                  << std::right << std::setw(10) << points.size() << " points"
+                  << std::setw(12) << std::fixed << std::setprecision(3) << best*1000 << " ms"
+                  << std::setw(10) << std::setprecision(2) << (double)flips / points.size() << " flips/point\n";
+    }
+
+    // face -> node index as it was before the dense vector, for comparison
+    class hashed_index {
+    public:
+        void add(int face_id, int node_id) { m_face_to_node[face_id] = node_id; }
+        int get_node(int face_id) const { return m_face_to_node.find(face_id)->second; }
+
+    private:
+        std::unordered_map<int,int> m_face_to_node;
+    };
+
+    // same index as graph::add and graph::get_node, without the nodes
+    class dense_index {
+    public:
+        void add(int face_id, int node_id)
+        {
+            if (face_id >= (int)m_face_to_node.size()) {
+                m_face_to_node.resize(std::max<int>(face_id+1, 2*m_face_to_node.size()), -1);
+            }
+            m_face_to_node[face_id] = node_id;
+        }
+        int get_node(int face_id) const { return m_face_to_node[face_id]; }
+
+    private:
+        std::vector<int> m_face_to_node;
+    };
+
+    // operation of the construction on the face -> node index, node is added or looked up
+    struct index_operation {
+        bool lookup;
+        int face_id;
+        int node_id;
+    };
+
+    // returns operations on the face -> node index in the order of the construction,
+    // a split or a flip looks up the nodes of its old faces and then adds their children,
+    // so the lookups of the nodes are done just before their first child is added
+    std::vector<index_operation> index_operations(const graph& history)
+    {
+        std::vector<std::vector<int>> parents(history.size());
+        for (int i = 0; i < history.size(); ++i) {
+            if (!history[i].leaf()) {
+                parents[history[i].child(0)].push_back(i);
+            }
+        }
+
+        std::vector<index_operation> result;
+        for (int i = 0; i < history.size(); ++i) {
+            for (int parent : parents[i]) {
+                result.push_back({true, history[parent].face(), parent});
+            }
+            if (history[i].face() > 0) {
+                result.push_back({false, history[i].face(), i});
+            }
+        }
+        return result;
+    }
+
+    template <typename index>
+    void replay(const std::string& name, const std::vector<index_operation>& operations, int repetitions)
+    {
+        double best = 0;
+        for (int i = 0; i < repetitions; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            index face_to_node;
+            int mismatches = 0;
+            for (const auto& operation : operations) {
+                if (operation.lookup) {
+                    mismatches += face_to_node.get_node(operation.face_id) != operation.node_id;
+                }
+                else {
+                    face_to_node.add(operation.face_id, operation.node_id);
+                }
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (mismatches != 0) {
+                std::cerr << name << ": " << mismatches << " wrong lookups\n";
+            }
+            if (i == 0 || elapsed.count() < best) {
+                best = elapsed.count();
+            }
+        }
+
+        std::cout << std::left << std::setw(24) << name
+                  << std::right << std::setw(10) << operations.size() << " ops  "
+                  << std::setw(12) << std::fixed << std::setprecision(3) << best*1000 << " ms"
+                  << std::setw(10) << std::setprecision(2) << best*1e9 / operations.size() << " ns/op\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int n = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    auto uniform = uniform_points(n);
+    auto sorted = sorted_points(n/10);
+    auto grid = grid_points(n);
+
+    delaunaytype::options brio;
+    brio.order = delaunaytype::insertion_order::brio;
+
+    delaunaytype::options batched;
+    batched.location = delaunaytype::point_location::batched_history_dag;
+    delaunaytype::options batched_brio = brio;
+    batched_brio.location = delaunaytype::point_location::batched_history_dag;
+
+    run("uniform, input order", uniform, {}, repetitions);
+    run("uniform, batched", uniform, batched, repetitions);
+    run("uniform, brio", uniform, brio, repetitions);
+    run("uniform, brio, batched", uniform, batched_brio, repetitions);
+    run("sorted, input order", sorted, {}, repetitions);
+    run("sorted, batched", sorted, batched, repetitions);
+    run("grid, brio", grid, brio, repetitions);
+
+    // lookups and adds of the history graph index replayed from the flip heavy construction
+    auto operations = index_operations(delaunay{sorted}.history_graph());
+    replay<hashed_index>("index, unordered_map", operations, repetitions);
+    replay<dense_index>("index, vector", operations, repetitions);
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+#include "clipped_voronoi.h"
+#include <cassert>
+#include <stdexcept>
+
+#include "convex_hull.h"
+
+clipped_voronoi::clipped_voronoi(const dcel& triangulation, const voronoi& graph)
+    : m_triangulation(triangulation)
+{
+    // corners are delaunay vertices, so the cell of every corner is known
+    auto corners_ids = convex_hull(triangulation).vertices_ids();
+    std::vector<util::point> corners;
+    for (int id : corners_ids) {
+        corners.push_back(triangulation.vertex(id-1).point());
+    }
+    walk(graph, corners, corners_ids, corners_ids[0]);
+    clip(graph);
+}
+
+clipped_voronoi::clipped_voronoi(const dcel& triangulation, const voronoi& graph, const std::vector<double>& box)
+    : m_triangulation(triangulation)
+    , m_box(true)
+{
+    if (box.size() != 4 || !(box[0] < box[1]) || !(box[2] < box[3])) {
+        throw std::invalid_argument("Box should be given as [min_x, max_x, min_y, max_y] with min < max");
+    }
+    std::vector<util::point> corners{{box[0], box[2]}, {box[1], box[2]}, {box[1], box[3]}, {box[0], box[3]}};
+    walk(graph, corners, {}, nearest_vertex(corners[0]));
+    clip(graph);
+}
+
+void clipped_voronoi::walk(const voronoi& graph, const std::vector<util::point>& corners, const std::vector<int>& corners_ids, int first_cell)
+{
+    // boundary edge a - b is p(u) = a + u(b-a), 0 <= u <= 1, the cell of vertex s is left at the
+    // nearest crossing with the bisector of s and its delaunay neighbour t that is farther along the edge,
+    // (p(u) - m)(t-s) = 0, where m is the middle point of s and t, so u = (m-a)(t-s) / (b-a)(t-s)
+    //
+    // projection of the cell vertex on the edge grows, so the walk cannot go back to a cell
+    int cell = first_cell;
+    int count = corners.size();
+    for (int k = 0; k < count; ++k) {
+        auto a = corners[k];
+        auto b = corners[(k+1) % count];
+        if (!corners_ids.empty()) {
+            cell = corners_ids[k];
+        }
+        m_boundary.push_back({a, k, -1, cell});
+
+        double dx = b.x() - a.x();
+        double dy = b.y() - a.y();
+        double u = 0;
+        while (true) {
+            auto s = m_triangulation.vertex(cell-1).point();
+            double exit_u = 1;
+            int exit_edge_id = -1;
+            for (auto edge : m_triangulation.vertex_edges(cell)) {
+                if (edge.has_negative_vertex()) {
+                    continue;
+                }
+                auto t = (edge | edgerelation::twin).point();
+                double wx = t.x() - s.x();
+                double wy = t.y() - s.y();
+                double projection = dx*wx + dy*wy;
+                if (projection <= 0) {
+                    continue;
+                }
+                double mx = (s.x() + t.x())/2 - a.x();
+                double my = (s.y() + t.y())/2 - a.y();
+                double crossing = (mx*wx + my*wy) / projection;
+                if (crossing >= u && crossing < exit_u) {
+                    exit_u = crossing;
+                    exit_edge_id = edge.id();
+                }
+            }
+            if (exit_edge_id == -1) {
+                // the rest of the edge is in the cell
+                break;
+            }
+
+            u = exit_u;
+            cell = (m_triangulation.edge(exit_edge_id-1) | edgerelation::twin).origin();
+            // edge of the cell that is left enters the boundary
+            m_boundary.push_back({{a.x() + u*dx, a.y() + u*dy}, k, graph.dual_edge(exit_edge_id), cell});
+        }
+    }
+}
+
+int clipped_voronoi::nearest_vertex(util::point p) const
+{
+    // greedy walk in the delaunay triangulation ends in the nearest vertex
+    int vertex_id = 1;
+    while (m_triangulation.vertex_removed(vertex_id-1)) {
+        ++vertex_id;
+    }
+
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        double distance = p.squared_distance(m_triangulation.vertex(vertex_id-1).point());
+        for (auto edge : m_triangulation.vertex_edges(vertex_id)) {
+            auto neighbour = edge | edgerelation::twin;
+            if (neighbour.origin() < 0) {
+                continue;
+            }
+            double neighbour_distance = p.squared_distance(neighbour.point());
+            if (neighbour_distance < distance) {
+                distance = neighbour_distance;
+                vertex_id = neighbour.origin();
+                moved = true;
+            }
+        }
+    }
+
+    return vertex_id;
+}
+
+void clipped_voronoi::clip(const voronoi& graph)
+{
+    const auto& voronoi_graph = graph.graph();
+    m_dcel = voronoi_graph;
+    int vertex_count = m_dcel.vertex_count();
+    int boundary_count = m_boundary.size();
+
+    // index of the boundary point where the edge with the given index enters the boundary, -1 if it doesn't
+    std::vector<int> entries(m_dcel.edge_count(), -1);
+    for (int j = 0; j < boundary_count; ++j) {
+        if (m_boundary[j].voronoi_edge != -1) {
+            entries[m_boundary[j].voronoi_edge-1] = j;
+        }
+    }
+
+    // vertices at infinity are outside, and a vertex is inside if the edge from its neighbour crosses
+    // the boundary once and the neighbour is outside or the edge doesn't cross it and the neighbour is inside,
+    // neighbours of a vertex are the neighbouring delaunay faces
+    std::vector<char> inside(vertex_count+1, 0);
+    std::vector<char> visited(vertex_count+1, 0);
+    std::vector<int> stack;
+    for (int face_id = 1; face_id < m_triangulation.face_count(); ++face_id) {
+        if (!m_triangulation.face_removed(face_id) && m_triangulation.imaginary(face_id) && !m_triangulation.bottom(face_id)) {
+            visited[face_id] = 1;
+            stack.push_back(face_id);
+        }
+    }
+    while (!stack.empty()) {
+        int face_id = stack.back();
+        stack.pop_back();
+        for (auto edge : m_triangulation.face_edges(face_id)) {
+            int neighbour_id = (edge | edgerelation::twin).face();
+            if (edge.has_negative_vertex() || neighbour_id == 0 || visited[neighbour_id]) {
+                continue;
+            }
+            int edge_index = graph.dual_edge(edge.id())-1;
+            int crossings = (entries[edge_index] != -1) + (entries[edge_index ^ 1] != -1);
+            inside[neighbour_id] = inside[face_id] ^ (crossings % 2);
+            visited[neighbour_id] = 1;
+            stack.push_back(neighbour_id);
+        }
+    }
+
+    // boundary point j becomes vertex vertex_count+j+1, boundary edge from it in the cell gets id first_boundary_edge_id+2j,
+    // its twin is in the external face
+    int first_boundary_edge_id = m_dcel.add_edges(boundary_count);
+    std::vector<int> face_edges(m_dcel.face_count(), -1);
+
+    // edges outside are removed, an edge that enters the boundary starts in the boundary point,
+    // and an edge that leaves it continues with the boundary edge from the boundary point
+    auto clip_edge = [&](int edge_index, bool origin_inside, bool destination_inside) {
+        auto edge = m_dcel.edge(edge_index);
+        if (!origin_inside) {
+            assert(entries[edge_index] != -1);
+            edge.set_origin(vertex_count + entries[edge_index] + 1);
+        }
+        if (!destination_inside) {
+            assert(entries[edge_index ^ 1] != -1);
+            edge.set_next(first_boundary_edge_id + 2*entries[edge_index ^ 1]);
+        }
+        face_edges[edge.face()] = edge.id();
+    };
+    for (int i = 0; i < voronoi_graph.edge_count(); i += 2) {
+        if (voronoi_graph.edge_removed(i)) {
+            continue;
+        }
+        bool origin_inside = inside[voronoi_graph.edge(i).origin()];
+        bool destination_inside = inside[voronoi_graph.edge(i+1).origin()];
+        if (!origin_inside && entries[i] == -1) {
+            // edge doesn't cross the boundary
+            assert(!destination_inside && entries[i+1] == -1);
+            m_dcel.remove_edge(i+1);
+            continue;
+        }
+        clip_edge(i, origin_inside, destination_inside);
+        clip_edge(i+1, destination_inside, origin_inside);
+    }
+
+    for (int j = 0; j < boundary_count; ++j) {
+        const auto& point = m_boundary[j];
+        const auto& next_point = m_boundary[(j+1) % boundary_count];
+        int edge_id = first_boundary_edge_id + 2*j;
+        int previous_edge_id = first_boundary_edge_id + 2*((j-1+boundary_count) % boundary_count);
+
+        // boundary edge continues with the edge that enters the boundary at the next point
+        auto edge = m_dcel.edge(edge_id-1);
+        edge.set_origin(vertex_count + j + 1);
+        int next_edge_id = first_boundary_edge_id + 2*((j+1) % boundary_count);
+        edge.set_next(next_point.voronoi_edge != -1 ? next_point.voronoi_edge : next_edge_id);
+        edge.set_face(point.cell);
+        face_edges[point.cell] = edge_id;
+
+        // twins go in the opposite direction
+        auto twin = m_dcel.edge(edge_id);
+        twin.set_origin(vertex_count + (j+1) % boundary_count + 1);
+        twin.set_next(previous_edge_id+1);
+        twin.set_face(0);
+
+        m_dcel.add(dceltype::vertex{point.point, edge_id});
+    }
+
+    for (int i = 0; i < m_dcel.edge_count(); ++i) {
+        if (!m_dcel.edge_removed(i)) {
+            m_dcel.edge(m_dcel.edge(i).next()-1).set_previous(i+1);
+        }
+    }
+    for (int vertex_id = 1; vertex_id <= vertex_count; ++vertex_id) {
+        if (!inside[vertex_id]) {
+            m_dcel.vertex(vertex_id-1).set_incident_edge(-1);
+        }
+    }
+    m_dcel.face(0).set_edge(boundary_count > 0 ? first_boundary_edge_id+1 : -1);
+    for (int face_id = 1; face_id < m_dcel.face_count(); ++face_id) {
+        if (face_edges[face_id] != -1) {
+            m_dcel.face(face_id).set_edge(face_edges[face_id]);
+        }
+        else if (!m_dcel.face_removed(face_id)) {
+            // cell is outside
+            m_dcel.remove_face(face_id);
+        }
+    }
+
+    m_boundary_edges.assign(vertex_count, -1);
+    m_crossed_edges.assign(vertex_count, -1);
+    m_boundary_cells.assign(vertex_count, -1);
+    for (const auto& point : m_boundary) {
+        m_boundary_edges.push_back(point.boundary_edge);
+        m_crossed_edges.push_back(point.voronoi_edge);
+        m_boundary_cells.push_back(point.cell);
+    }
+}
+
+const dcel& clipped_voronoi::graph() const
+{
+    return m_dcel;
+}
+
+int clipped_voronoi::boundary_edge(int vertex_id) const
+{
+    return m_boundary_edges[vertex_id-1];
+}
+
+int clipped_voronoi::crossed_edge(int vertex_id) const
+{
+    return m_crossed_edges[vertex_id-1];
+}
+
+int clipped_voronoi::boundary_cell(int vertex_id) const
+{
+    return m_boundary_cells[vertex_id-1];
+}
+
+bool clipped_voronoi::box() const
+{
+    return m_box;
+}
+
+std::vector<util::line_segment> clipped_voronoi::get_edges() const
+{
+    std::vector<util::line_segment> result;
+
+    // skip removed and twin edges
+    for (int i = 0; i < m_dcel.edge_count(); ++i) {
+        auto edge = m_dcel.edge(i);
+        if (m_dcel.edge_removed(i) || edge.twin() < edge.id()) {
+            continue;
+        }
+        auto origin = edge.point();
+        auto destination = (edge | edgerelation::twin).point();
+        if (origin != destination) {
+            result.emplace_back(origin, destination);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,87 @@
+#ifndef CLIPPED_VORONOI_H
+#define CLIPPED_VORONOI_H
+
+#include <vector>
+
+#include "dcel.h"
+#include "voronoi.h"
+#include "utility.h"
+
+namespace clippedtype {
+    // point of the boundary, corner or clip point
+    struct boundary_point {
+        util::point point;
+        // index of the boundary edge that starts at the point or contains it
+        int boundary_edge;
+        // id of the voronoi edge entering the boundary at the point, -1 for a corner
+        int voronoi_edge;
+        // id of the delaunay vertex whose cell has the boundary up to the next point
+        int cell;
+    };
+}
+
+class clipped_voronoi {
+    // voronoi graph whose cells are clipped to a convex boundary, the convex hull
+    // of the triangulation or a box, so there are no vertices at infinity
+    //
+    //    +-----o------+
+    //    |     |      |        x - voronoi vertex inside the boundary
+    //    o-----x      |        o - clip point, vertex on the boundary
+    //    |      \     |        + - corner of the boundary
+    //    |       x----o
+    //    |       |    |
+    //    +-------o----+
+    //
+    // the boundary is walked through the cells of the delaunay vertices, so the clip points
+    // are computed from the bisectors of the delaunay vertices and not from the vertices at infinity
+    //
+    // ids of the voronoi vertices and edges are kept, vertices and edges outside the boundary
+    // are removed, clipped edges get the clip points as the new origins, and the boundary edges
+    // and clip points are added after them, the boundary is in positive direction in the cells,
+    // and its twins form the external face (0)
+public:
+    // clips the cells to the convex hull of the triangulation
+    clipped_voronoi(const dcel& triangulation, const voronoi& graph);
+    // clips the cells to the box given as [min_x, max_x, min_y, max_y]
+    // throws std::invalid_argument if the box doesn't have 4 values or a min is not less than its max
+    clipped_voronoi(const dcel& triangulation, const voronoi& graph, const std::vector<double>& box);
+
+    const dcel& graph() const;
+
+    // returns index of the boundary edge the vertex lies on,
+    // -1 for the voronoi vertices inside the boundary
+    int boundary_edge(int vertex_id) const;
+    // returns id of the voronoi edge that enters the boundary at the clip point,
+    // -1 for the voronoi vertices and the corners of the boundary
+    int crossed_edge(int vertex_id) const;
+    // returns id of the delaunay vertex whose cell has the boundary from the vertex on,
+    // -1 for the voronoi vertices inside the boundary
+    int boundary_cell(int vertex_id) const;
+    // returns true if the cells are clipped to a box, false if to the convex hull
+    bool box() const;
+
+    // returns edges of the clipped graph including the boundary
+    std::vector<util::line_segment> get_edges() const;
+
+private:
+    // walks the boundary given by corners from the cell of the first corner,
+    // if corners are delaunay vertices, their ids are given
+    void walk(const voronoi& graph, const std::vector<util::point>& corners, const std::vector<int>& corners_ids, int first_cell);
+    // returns delaunay vertex nearest to the point
+    int nearest_vertex(util::point p) const;
+    // builds the clipped graph from the voronoi graph and the boundary points
+    void clip(const voronoi& graph);
+
+    const dcel& m_triangulation;
+    // boundary points in positive direction
+    std::vector<clippedtype::boundary_point> m_boundary;
+    // clipped voronoi graph
+    dcel m_dcel;
+    // boundary edges, crossed edges and boundary cells of the vertices
+    std::vector<int> m_boundary_edges;
+    std::vector<int> m_crossed_edges;
+    std::vector<int> m_boundary_cells;
+    bool m_box = false;
+};
+
+#endif /* CLIPPED_VORONOI_H */
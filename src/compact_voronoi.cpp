@@ -0,0 +1,49 @@
+#include "compact_voronoi.h"
+
+#include "voronoi.h"
+
+compact_voronoi::compact_voronoi(const dcel& triangulation, int threads)
+    : m_vertices(voronoi::vertices(triangulation, threads))
+{
+    // every real delaunay edge gives a vertex to the cell of its origin
+    int vertex_count = triangulation.vertex_count();
+    m_offsets.reserve(vertex_count+1);
+    m_indices.reserve(triangulation.edge_count());
+    m_offsets.push_back(0);
+
+    for (int i = 0; i < vertex_count; ++i) {
+        if (!triangulation.vertex_removed(i)) {
+            // cell starts at the same edge as the face of the graph
+            for (auto edge : voronoi::out_edges(triangulation, i)) {
+                if (!edge.has_negative_vertex()) {
+                    m_indices.push_back((edge | edgerelation::twin).face()-1);
+                }
+            }
+        }
+        m_offsets.push_back(m_indices.size());
+    }
+}
+
+const std::vector<util::point>& compact_voronoi::vertices() const
+{
+    return m_vertices;
+}
+
+const std::vector<int>& compact_voronoi::offsets() const
+{
+    return m_offsets;
+}
+
+const std::vector<int>& compact_voronoi::indices() const
+{
+    return m_indices;
+}
+
+std::vector<util::point> compact_voronoi::cell(int vertex_id) const
+{
+    std::vector<util::point> result;
+    for (int j = m_offsets[vertex_id-1]; j < m_offsets[vertex_id]; ++j) {
+        result.push_back(m_vertices[m_indices[j]]);
+    }
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef COMPACT_VORONOI_H
+#define COMPACT_VORONOI_H
+
+#include <vector>
+
+#include "dcel.h"
+#include "utility.h"
+
+class compact_voronoi {
+    // cells of the voronoi graph as polygons in compressed sparse rows, built from
+    // the triangulation in one pass without the half-edge graph
+    //
+    //    vertices  v1 v2 v3 v4 v5 ...      voronoi vertex for the delaunay face with id i is at index i-1
+    //    offsets   0  3  7  ...            cell of the delaunay vertex with id i has the vertices
+    //    indices   4  0  2  2  0  1  5     indices[offsets[i-1]] ... indices[offsets[i]-1]
+    //
+    // vertices of a cell are in positive direction and they are the origins of the edges of the
+    // cell in voronoi::graph, cells of the convex hull vertices have two vertices far away and
+    // they are not closed by an edge between them, like in the graph, cells of removed vertices are empty
+public:
+    // vertices are computed on the given number of threads
+    compact_voronoi(const dcel& triangulation, int threads = 1);
+
+    const std::vector<util::point>& vertices() const;
+    const std::vector<int>& offsets() const;
+    const std::vector<int>& indices() const;
+
+    // returns vertices of the cell of the delaunay vertex with the given id
+    std::vector<util::point> cell(int vertex_id) const;
+
+private:
+    std::vector<util::point> m_vertices;
+    // offsets of the cells in the indices, there is one more offset than cells
+    std::vector<int> m_offsets;
+    // indices of the vertices of the cells
+    std::vector<int> m_indices;
+};
+
+#endif /* COMPACT_VORONOI_H */
@@ -2,22 +2,20 @@
 #include <algorithm>
 
 convex_hull::convex_hull(const dcel& triangulation)
-    : m_edges(get_edges(get_vertices(triangulation)))
+    : m_vertices_ids(get_vertices(triangulation))
+    , m_edges(get_edges(triangulation))
 {
 }
 
-std::vector<util::point> convex_hull::get_vertices(const dcel& triangulation) const
+std::vector<int> convex_hull::get_vertices(const dcel& triangulation) const
 {
-    std::vector<util::point> convex_hull_vertices;
+    std::vector<int> convex_hull_vertices;
 
-    // get an edge departing from 0 point
-    auto current_edge = triangulation.edge(triangulation.vertex(0).incident_edge()-1);
-
-    // get edge 0 -> dceltype::point_minus_2
-    while (!(current_edge.origin() == 1 && (current_edge | edgerelation::twin).origin() == dceltype::point_minus_2)) {
-        // Get next edge departing from 0 point.
-        current_edge = current_edge | edgerelation::previous | edgerelation::twin;
-    }
+    // get edge 0 -> dceltype::point_minus_2 from the edges departing from 0 point
+    auto star = triangulation.vertex_edges(1);
+    auto current_edge = *std::find_if(star.begin(), star.end(), [](auto edge) {
+        return (edge | edgerelation::twin).origin() == dceltype::point_minus_2;
+    });
 
     // get previous edge as it is the first edge in the convex hull
     current_edge = current_edge | edgerelation::previous;
@@ -26,7 +24,7 @@ std::vector<util::point> convex_hull::get_vertices(const dcel& triangulation) co
     // get convex hull vertices
     do {
         // insert next point
-        convex_hull_vertices.push_back(current_edge.point());
+        convex_hull_vertices.push_back(current_edge.origin());
         // get next edge
         current_edge = current_edge | edgerelation::previous | edgerelation::twin | edgerelation::previous;
         // if point is imaginary then skip the edge
@@ -43,14 +41,23 @@ const std::vector<util::line_segment> convex_hull::edges() const
     return m_edges;
 }
 
-std::vector<util::line_segment> convex_hull::get_edges(const std::vector<util::point>& convex_hull_vertices) const
+const std::vector<int>& convex_hull::vertices_ids() const
+{
+    return m_vertices_ids;
+}
+
+std::vector<util::line_segment> convex_hull::get_edges(const dcel& triangulation) const
 {
+    auto point = [&](int i) {
+        return triangulation.vertex(m_vertices_ids[i]-1).point();
+    };
+
     std::vector<util::line_segment> result;
-    for (int i = 0; i < (int)convex_hull_vertices.size()-1; ++i) {
-        result.emplace_back(convex_hull_vertices[i], convex_hull_vertices[i+1]);
+    for (int i = 0; i < (int)m_vertices_ids.size()-1; ++i) {
+        result.emplace_back(point(i), point(i+1));
     }
 
-    result.emplace_back(convex_hull_vertices.back(), convex_hull_vertices[0]);
+    result.emplace_back(point(m_vertices_ids.size()-1), point(0));
     return result;
 }
 
@@ -9,6 +9,9 @@ public:
     convex_hull(const dcel& triangulation);
 
     const std::vector<util::line_segment> edges() const;
+    // ids of the delaunay vertices of the convex hull in positive direction,
+    // edge i goes from vertex i to vertex i+1
+    const std::vector<int>& vertices_ids() const;
 
     // returns true if point p is inside a convex hull (including edges)
     bool inside(const util::point& p) const;
@@ -18,9 +21,10 @@ public:
     std::vector<util::point> get_inersection(const util::point& origin, const util::point& destination);
 
 private:
-    std::vector<util::point> get_vertices(const dcel& triangulation) const;
-    std::vector<util::line_segment> get_edges(const std::vector<util::point>& convex_hull_vertices) const;
+    std::vector<int> get_vertices(const dcel& triangulation) const;
+    std::vector<util::line_segment> get_edges(const dcel& triangulation) const;
 
+    std::vector<int> m_vertices_ids;
     // convex hull edges in positive direction
     std::vector<util::line_segment> m_edges;
 };
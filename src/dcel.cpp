@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 
 #define EXTERNAL_FACE (0)
@@ -77,9 +78,8 @@ std::ostream& dceltype::operator<<(std::ostream& out, const dceltype::vertex& v)
 }
 
 // edge
-dceltype::edge::edge(int origin, int twin, int previous, int next, int face)
+dceltype::edge::edge(int origin, int previous, int next, int face)
     : m_origin(origin)
-    , m_twin(twin)
     , m_previous(previous)
     , m_next(next)
     , m_face(face)
@@ -91,11 +91,6 @@ int dceltype::edge::origin() const
     return m_origin;
 }
 
-int dceltype::edge::twin() const
-{
-    return m_twin;
-}
-
 int dceltype::edge::previous() const
 {
     return m_previous;
@@ -116,11 +111,6 @@ void dceltype::edge::set_origin(int origin)
     m_origin = origin;
 }
 
-void dceltype::edge::set_twin(int twin)
-{
-    m_twin = twin;
-}
-
 void dceltype::edge::set_previous(int previous)
 {
     m_previous = previous;
@@ -138,7 +128,7 @@ void dceltype::edge::set_face(int face)
 
 std::ostream& dceltype::operator<<(std::ostream& out, const dceltype::edge& e)
 {
-    return out << "(" << e.origin() << "," << e.twin() << "," << e.previous() << "," << e.next() << "," << e.face() << ")";
+    return out << "(" << e.origin() << "," << e.previous() << "," << e.next() << "," << e.face() << ")";
 }
 
 // face
@@ -169,11 +159,12 @@ dcel::dcel(const std::vector<util::point>& points)
         throw std::runtime_error("Minimum number of points is 3");
     }
     std::transform(points.cbegin(), points.cend(), std::back_inserter(m_vertices), [](util::point p) { return dceltype::vertex(p); });
+    m_integral = std::all_of(points.cbegin(), points.cend(), [](util::point p) { return util::integral(p); });
 }
 
 void dcel::set_highest_first()
 {
-    assert(m_edges.empty() && m_faces.empty() && !m_vertices.empty());
+    assert(m_edge_origins.empty() && m_faces.empty() && !m_vertices.empty());
     int index_of_highest = get_highest_vertex_index();
     std::swap(m_vertices[0], m_vertices[index_of_highest]);
 }
@@ -185,7 +176,7 @@ int dcel::vertex_count() const
 
 int dcel::edge_count() const
 {
-    return m_edges.size();
+    return m_edge_origins.size();
 }
 
 int dcel::face_count() const
@@ -220,17 +211,184 @@ const std::vector<dceltype::vertex>& dcel::vertices() const
 
 void dcel::add(dceltype::vertex v)
 {
+    m_integral = m_integral && util::integral(v.point());
     m_vertices.emplace_back(std::move(v));
 }
 
+void dcel::set_point(int vertex_index, util::point point)
+{
+    // predicates stay integral only if all points are integral
+    m_integral = m_integral && util::integral(point);
+    m_vertices[vertex_index] = dceltype::vertex{point, m_vertices[vertex_index].incident_edge()};
+}
+
 void dcel::add(dceltype::edge e)
 {
-    m_edges.emplace_back(std::move(e));
+    m_edge_origins.push_back(e.origin());
+    m_edge_previous.push_back(e.previous());
+    m_edge_next.push_back(e.next());
+    m_edge_faces.push_back(e.face());
 }
 
 void dcel::add(dceltype::face f)
 {
     m_faces.emplace_back(std::move(f));
+    m_face_flags.push_back(0);
+}
+
+int dcel::new_edge()
+{
+    if (!m_free_edges.empty()) {
+        int edge_id = m_free_edges.back();
+        m_free_edges.pop_back();
+        return edge_id;
+    }
+
+    add(dceltype::edge{0, -1, -1, -1});
+    add(dceltype::edge{0, -1, -1, -1});
+    return edge_count()-1;
+}
+
+int dcel::add_edges(int pair_count)
+{
+    int first_edge_id = edge_count()+1;
+    m_edge_origins.resize(m_edge_origins.size() + 2*pair_count, 0);
+    m_edge_previous.resize(m_edge_previous.size() + 2*pair_count, -1);
+    m_edge_next.resize(m_edge_next.size() + 2*pair_count, -1);
+    m_edge_faces.resize(m_edge_faces.size() + 2*pair_count, -1);
+    return first_edge_id;
+}
+
+int dcel::new_face()
+{
+    if (!m_free_faces.empty()) {
+        int face_id = m_free_faces.back();
+        m_free_faces.pop_back();
+        return face_id;
+    }
+
+    add(dceltype::face{});
+    return face_count()-1;
+}
+
+void dcel::set_edge(int edge_id, dceltype::edge e)
+{
+    m_edge_origins[edge_id-1] = e.origin();
+    m_edge_previous[edge_id-1] = e.previous();
+    m_edge_next[edge_id-1] = e.next();
+    m_edge_faces[edge_id-1] = e.face();
+}
+
+void dcel::remove_edge(int edge_id)
+{
+    int first_id = std::min(edge_id, dceltype::twin(edge_id));
+    assert(!edge_removed(first_id-1) && !edge_removed(first_id));
+    set_edge(first_id, dceltype::edge{0, -1, -1, -1});
+    set_edge(first_id+1, dceltype::edge{0, -1, -1, -1});
+    m_free_edges.push_back(first_id);
+}
+
+void dcel::remove_face(int face_id)
+{
+    assert(!face_removed(face_id));
+    m_faces[face_id].set_edge(-1);
+    m_free_faces.push_back(face_id);
+}
+
+bool dcel::edge_removed(int edge_index) const
+{
+    return m_edge_origins[edge_index] == 0;
+}
+
+bool dcel::face_removed(int face_id) const
+{
+    return m_faces[face_id].edge() == -1;
+}
+
+bool dcel::vertex_removed(int vertex_index) const
+{
+    return m_vertices[vertex_index].incident_edge() == -1;
+}
+
+void dcel::add_triangles(const std::vector<std::array<int,3>>& triangles)
+{
+    assert(m_edge_origins.empty() && m_faces.empty());
+
+    // key of an undirected edge is (smaller id, bigger id)
+    auto key = [](int origin, int destination) {
+        return ((std::uint64_t)(std::uint32_t)std::min(origin, destination) << 32) | (std::uint32_t)std::max(origin, destination);
+    };
+
+    // (key, 3i+j) for edge j of triangle i sorted by key, so twins are adjacent
+    std::vector<std::pair<std::uint64_t, int>> triangle_edges;
+    triangle_edges.reserve(3*triangles.size());
+    for (int i = 0; i < (int)triangles.size(); ++i) {
+        for (int j = 0; j < 3; ++j) {
+            triangle_edges.emplace_back(key(triangles[i][j], triangles[i][(j+1)%3]), 3*i+j);
+        }
+    }
+    std::sort(triangle_edges.begin(), triangle_edges.end());
+
+    // each undirected edge gets a pair of ids, id of edge j of triangle i is ids[3i+j]
+    std::vector<int> ids(3*triangles.size());
+    // edges of the external face, (origin id, edge id)
+    std::vector<std::pair<int,int>> external_edges;
+
+    int pair_count = 0;
+    for (int k = 0; k < (int)triangle_edges.size(); ++pair_count) {
+        int first_id = 2*pair_count+1;
+        ids[triangle_edges[k].second] = first_id;
+        if (k+1 < (int)triangle_edges.size() && triangle_edges[k+1].first == triangle_edges[k].first) {
+            ids[triangle_edges[k+1].second] = first_id+1;
+            k += 2;
+        }
+        else {
+            // edge is on the boundary, its twin is in the external face
+            int triangle_edge = triangle_edges[k].second;
+            external_edges.emplace_back(triangles[triangle_edge/3][(triangle_edge%3+1)%3], first_id+1);
+            k += 1;
+        }
+    }
+
+    // previous and next edges of the external face are set below
+    m_edge_origins.assign(2*pair_count, 0);
+    m_edge_previous.assign(2*pair_count, -1);
+    m_edge_next.assign(2*pair_count, -1);
+    m_edge_faces.assign(2*pair_count, EXTERNAL_FACE);
+
+    // external face, its edge will be set below
+    add(dceltype::face{});
+
+    for (int i = 0; i < (int)triangles.size(); ++i) {
+        for (int j = 0; j < 3; ++j) {
+            int origin = triangles[i][j];
+            int edge_id = ids[3*i+j];
+            set_edge(edge_id, dceltype::edge{origin, ids[3*i+(j+2)%3], ids[3*i+(j+1)%3], i+1});
+
+            if (origin > 0) {
+                m_vertices[origin-1].set_incident_edge(edge_id);
+            }
+        }
+        add(dceltype::face{ids[3*i]});
+    }
+
+    for (auto [origin, edge_id] : external_edges) {
+        m_edge_origins[edge_id-1] = origin;
+    }
+
+    // link edges of the external face
+    for (auto [origin, edge_id] : external_edges) {
+        int destination = m_edge_origins[dceltype::twin(edge_id)-1];
+        auto next = std::find_if(external_edges.begin(), external_edges.end(), [&](auto e) { return e.first == destination; });
+        assert(next != external_edges.end());
+        m_edge_next[edge_id-1] = next->second;
+        m_edge_previous[next->second-1] = edge_id;
+    }
+
+    assert(!external_edges.empty());
+    m_faces[EXTERNAL_FACE].set_edge(external_edges.front().second);
+
+    classify();
 }
 
 bool dcel::external_edge(int edge_index) const
@@ -258,7 +416,7 @@ util::direction dcel::get_direction(util::point p, int source_point_id, int dest
         // direction negative - point is not in the triangle
         // direction positive - point can be in the triangle (need to check other edges)
         // direction collinear - point is on the line segment of triangle edge
-        return m_vertices[source_point_id-1].point().get_direction(m_vertices[destination_point_id-1].point(), p);
+        return direction(m_vertices[source_point_id-1].point(), m_vertices[destination_point_id-1].point(), p);
     }
 
     if (source_point_id > 0 && destination_point_id == dceltype::point_minus_2) {
@@ -301,6 +459,102 @@ util::direction dcel::get_direction(util::point p, int source_point_id, int dest
             util::direction::positive : util::direction::negative;
 }
 
+void dcel::add_direction(util::orientation_batch& batch, int source_point_id, int destination_point_id) const
+{
+    util::point source = (source_point_id > 0) ? m_vertices[source_point_id-1].point() : util::point{};
+    util::point destination = (destination_point_id > 0) ? m_vertices[destination_point_id-1].point() : util::point{};
+    add_direction(batch, source_point_id, source, destination_point_id, destination);
+}
+
+unsigned dcel::add_directions(util::orientation_batch& batch, const std::array<int,3>& ids, const std::array<int,3>& skip) const
+{
+    // every point is read once
+    std::array<util::point,3> points;
+    for (int i = 0; i < 3; ++i) {
+        if (ids[i] > 0) {
+            points[i] = m_vertices[ids[i]-1].point();
+        }
+    }
+
+    int first = batch.count;
+    for (int i = 0; i < 3; ++i) {
+        int j = (i + 1) % 3;
+        add_direction(batch, ids[i], points[i], ids[j], points[j]);
+        // the lane is overwritten by the next one if the edge is skipped
+        bool skipped = (ids[i] == skip[0] && ids[j] == skip[1]) ||
+                       (ids[i] == skip[1] && ids[j] == skip[2]) ||
+                       (ids[i] == skip[2] && ids[j] == skip[0]);
+        batch.count -= skipped;
+    }
+
+    return ((1u << batch.count) - 1) & ~((1u << first) - 1);
+}
+
+void dcel::add_direction(util::orientation_batch& batch, int source_point_id, util::point source, 
+                         int destination_point_id, util::point destination) const
+{
+    // the same cases as in get_direction
+    if (source_point_id > 0 && destination_point_id > 0) {
+        batch.add(source, destination);
+    }
+    else if (source_point_id > 0) {
+        // negative if p > source for point_minus_2, otherwise for point_minus_1
+        batch.add_symbolic(source, destination_point_id == dceltype::point_minus_1);
+    }
+    else if (destination_point_id > 0) {
+        // negative if p > destination for point_minus_1, otherwise for point_minus_2
+        batch.add_symbolic(destination, source_point_id == dceltype::point_minus_2);
+    }
+    else {
+        // point_minus_2 - point_minus_1
+        batch.add_positive();
+    }
+}
+
+util::direction dcel::direction(util::point a, util::point b, util::point c) const
+{
+    if (!m_integral) {
+        return a.get_direction(b, c);
+    }
+
+    std::int64_t area = util::orient2d_integer(a, b, c);
+    return (area > 0) ? 
+            util::direction::positive :
+           (area < 0) ? 
+            util::direction::negative : 
+            util::direction::collinear;
+}
+
+bool dcel::in_circle(util::point p, util::point a, util::point b, util::point c) const
+{
+    return m_integral ? util::in_circle_integer(a, b, c, p) > 0 : p.in_circle(a, b, c);
+}
+
+bool dcel::integral() const
+{
+    return m_integral;
+}
+
+util::direction dcel::orientation(int a, int b, int c) const
+{
+    auto opposite = [](util::direction direction) {
+        return (direction == util::direction::positive) ? util::direction::negative :
+               (direction == util::direction::negative) ? util::direction::positive : direction;
+    };
+
+    // rotate a - b - c, so the first point is a normal point
+    if (a < 0) {
+        return (b > 0) ? orientation(b, c, a) : orientation(c, a, b);
+    }
+
+    if (b == dceltype::point_minus_1 && c == dceltype::point_minus_2) {
+        // get_direction expects point_minus_2 - point_minus_1
+        return opposite(get_direction(m_vertices[a-1].point(), c, b));
+    }
+
+    return get_direction(m_vertices[a-1].point(), b, c);
+}
+
 int dcel::collinear_edge_id(int point_index, int face_id) const
 {
     auto face_edge = edge(face(face_id).edge()-1);
@@ -325,93 +579,126 @@ int dcel::collinear_edge_id(int point_index, int face_id) const
 
 bool dcel::imaginary(int face_id) const
 {
-    auto vertices_ids = points_ids(face_id);
-    return face_id == EXTERNAL_FACE || 
-           std::any_of(vertices_ids.begin(), vertices_ids.end(), [](int id) { return id < 0; });
+    assert(m_face_flags[face_id] & dceltype::classified_face);
+    return m_face_flags[face_id] & dceltype::imaginary_face;
+}
+
+bool dcel::hull_adjacent(int face_id) const
+{
+    assert(m_face_flags[face_id] & dceltype::classified_face);
+    return m_face_flags[face_id] & dceltype::hull_adjacent_face;
+}
+
+void dcel::classify(int face_id)
+{
+    if (face_id == EXTERNAL_FACE) {
+        m_face_flags[face_id] = dceltype::classified_face | dceltype::imaginary_face;
+        return;
+    }
+    if (face_removed(face_id)) {
+        m_face_flags[face_id] = dceltype::classified_face;
+        return;
+    }
+
+    int imaginary_points_count = 0;
+    bool imaginary_neighbour = false;
+    for (auto edge_in_face : face_edges(face_id)) {
+        imaginary_points_count += edge_in_face.origin() < 0;
+
+        // neighbour of a real face is imaginary if it is external or its third vertex is imaginary
+        auto twin = edge_in_face | edgerelation::twin;
+        imaginary_neighbour = imaginary_neighbour || twin.face() == EXTERNAL_FACE || (twin | edgerelation::previous).origin() < 0;
+    }
+
+    m_face_flags[face_id] = dceltype::classified_face | ((imaginary_points_count > 0) ? 
+        (dceltype::imaginary_face | (imaginary_points_count == 2 ? dceltype::bottom_face : 0)) :
+        (imaginary_neighbour ? dceltype::hull_adjacent_face : 0));
+}
+
+void dcel::classify()
+{
+    for (int face_id = 0; face_id < face_count(); ++face_id) {
+        classify(face_id);
+    }
 }
 
 std::vector<int> dcel::points_ids(int face_id) const
 {
     std::vector<int> result;
-    auto edge_in_face = edge(face(face_id).edge()-1);
-    int first_edge_id = edge_in_face.id();
-
-    do {
+    for (auto edge_in_face : face_edges(face_id)) {
         result.emplace_back(edge_in_face.origin());
-        edge_in_face = edge_in_face | edgerelation::next;
-    } while (edge_in_face.id() != first_edge_id);
-
+    }
     return result;
 }
 
 std::vector<util::point> dcel::points(int face_id) const
 {
     std::vector<util::point> result;
-    auto edge_in_face = edge(face(face_id).edge()-1);
-    int first_edge_id = edge_in_face.id();
-
-    do {
+    for (auto edge_in_face : face_edges(face_id)) {
         if (edge_in_face.origin() > 0) {
             result.emplace_back(edge_in_face.point());
         }
-        edge_in_face = edge_in_face | edgerelation::next;
-    } while (edge_in_face.id() != first_edge_id);
-
+    }
     return result;
 }
 
 util::point dcel::point(int face_id) const
 {
-    auto edge_in_face = edge(face(face_id).edge()-1);
-    int first_edge_id = edge_in_face.id();
-
-    do {
+    for (auto edge_in_face : face_edges(face_id)) {
         if (edge_in_face.origin() > 0) {
             return edge_in_face.point();
         }
-        edge_in_face = edge_in_face | edgerelation::next;
-    } while (edge_in_face.id() != first_edge_id);
+    }
 
     // we should not reach this
     assert(false);
     return util::point();
 }
 
-bool dcel::bottom(int face_id) const
+std::array<int,3> dcel::triangle_ids(int face_id) const
 {
-    auto ids = points_ids(face_id);
-    int imaginary_points_count = std::count_if(ids.begin(), ids.end(), [](int id) { return id < 0; });
-    return imaginary_points_count == 2;
+    auto edge_in_face = face_edge(face_id);
+    auto next_edge = edge_in_face | edgerelation::next;
+    auto previous_edge = edge_in_face | edgerelation::previous;
+    assert((next_edge | edgerelation::next).id() == previous_edge.id());
+    return {edge_in_face.origin(), next_edge.origin(), previous_edge.origin()};
 }
 
-// edgeref
-template<>
-void dcel::edgeref<false>::set_origin(int origin)
+std::array<util::point,3> dcel::triangle_points(int face_id) const
+{
+    auto ids = triangle_ids(face_id);
+    assert(ids[0] > 0 && ids[1] > 0 && ids[2] > 0);
+    return {m_vertices[ids[0]-1].point(), m_vertices[ids[1]-1].point(), m_vertices[ids[2]-1].point()};
+}
+
+bool dcel::bottom(int face_id) const
 {
-    d->m_edges[edge_index].set_origin(origin);
+    assert(m_face_flags[face_id] & dceltype::classified_face);
+    return m_face_flags[face_id] & dceltype::bottom_face;
 }
 
+// edgeref
 template<>
-void dcel::edgeref<false>::set_twin(int twin)
+void dcel::edgeref<false>::set_origin(int origin)
 {
-    d->m_edges[edge_index].set_twin(twin);
+    d->m_edge_origins[edge_index] = origin;
 }
 
 template<>
 void dcel::edgeref<false>::set_previous(int previous)
 {
-    d->m_edges[edge_index].set_previous(previous);
+    d->m_edge_previous[edge_index] = previous;
 }
 
 template<>
 void dcel::edgeref<false>::set_next(int next)
 {
-    d->m_edges[edge_index].set_next(next);
+    d->m_edge_next[edge_index] = next;
 }
 
 template<>
 void dcel::edgeref<false>::set_face(int face)
 {
-    d->m_edges[edge_index].set_face(face);
+    d->m_edge_faces[edge_index] = face;
 }
 
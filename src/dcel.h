@@ -3,10 +3,14 @@
 
 #include <iostream>
 #include <vector>
+#include <array>
+#include <iterator>
 #include <type_traits>
 #include <cassert>
+#include <cstdint>
 
 #include "utility.h"
+#include "predicates.h"
 
 namespace dceltype {
     // Highest intput point (point with id 1), point_minus_2 and point_minus_1 
@@ -43,25 +47,24 @@ namespace dceltype {
         int m_incident_edge;
     };
 
+    // edge has no twin field, twins are stored in adjacent slots (1-2, 3-4, ...),
+    // see twin
     class edge {
     public:
-        edge(int origin, int twin, int previous, int next, int face);
+        edge(int origin, int previous, int next, int face);
 
         int origin() const;
-        int twin() const;
         int previous() const;
         int next() const;
         int face() const;
 
         void set_origin(int origin);
-        void set_twin(int twin);
         void set_previous(int previous);
         void set_next(int next);
         void set_face(int face);
 
     private:
         int m_origin;
-        int m_twin;
         int m_previous;
         int m_next;
         int m_face;
@@ -78,6 +81,31 @@ namespace dceltype {
         int m_edge;
     };
 
+    // faces of the triangulation changed by adding a point or removing a vertex,
+    // face ids are reused, so a destroyed face id can also be a created face id
+    // with a new triangle in it
+    struct changes {
+        // id of the added or removed vertex
+        int vertex_id;
+        // ids of faces with new triangles, sorted
+        std::vector<int> created_faces;
+        // ids of faces whose triangles don't exist anymore, sorted
+        std::vector<int> destroyed_faces;
+    };
+
+    // bits of the cached face flags, see dcel::classify
+    constexpr std::uint8_t imaginary_face = 1;
+    constexpr std::uint8_t bottom_face = 2;
+    constexpr std::uint8_t hull_adjacent_face = 4;
+    // set by dcel::classify, the other flags of a face without it are not computed yet
+    constexpr std::uint8_t classified_face = 8;
+
+    // returns id of the twin of the edge with the given id
+    inline int twin(int edge_id)
+    {
+        return ((edge_id-1) ^ 1) + 1;
+    }
+
     std::ostream& operator<<(std::ostream& out, const dceltype::vertex& v);
     std::ostream& operator<<(std::ostream& out, const dceltype::edge& e);
     std::ostream& operator<<(std::ostream& out, const dceltype::face& f);
@@ -85,6 +113,11 @@ namespace dceltype {
 
 enum class edgerelation { twin, previous, next };
 
+class snapshot;
+namespace snapshottype {
+    class dcel_view;
+}
+
 class dcel {
 public:
     dcel() = default;
@@ -102,6 +135,22 @@ public:
     // returns direction of p - source point - destination point
     // direction can be positive, negative or collinear
     util::direction get_direction(util::point p, int source_point_id, int destination_point_id) const;
+    // adds lane that is negative iff get_direction(p, source, destination) is negative,
+    // point_minus_2 and point_minus_1 are resolved when the lane is added, so the
+    // batch itself is evaluated without branches
+    void add_direction(util::orientation_batch& batch, int source_point_id, int destination_point_id) const;
+    // adds lanes of edges a - b, b - c and c - a of the triangle, except the edges of
+    // the triangle skip, their directions are known, returns mask of the added lanes
+    unsigned add_directions(util::orientation_batch& batch, const std::array<int,3>& ids, const std::array<int,3>& skip) const;
+    // returns direction of a - b - c and true if p is strictly inside the circumcircle
+    // of (a,b,c), the predicates are evaluated in integers if the dcel is integral
+    util::direction direction(util::point a, util::point b, util::point c) const;
+    bool in_circle(util::point p, util::point a, util::point b, util::point c) const;
+    // returns true if all vertices have integral coordinates, see util::integral
+    bool integral() const;
+    // returns direction of a - b - c given by vertices ids,
+    // any of them can be point_minus_2 or point_minus_1
+    util::direction orientation(int a, int b, int c) const;
 
     int vertex_count() const;
     int edge_count() const;
@@ -116,15 +165,53 @@ public:
     const std::vector<dceltype::vertex>& vertices() const;
 
     void add(dceltype::vertex v);
+    // moves the vertex with the given index to the point
+    void set_point(int vertex_index, util::point point);
+    // edges are added in pairs of twins, the edge with odd id first
     void add(dceltype::edge e);
     void add(dceltype::face f);
 
+    // removed edges and faces are kept in free lists, so their slots are reused
+    // returns id of a new edge or face, it is set by the caller
+    // new_edge returns id of a pair of twins, the second edge has id+1
+    int new_edge();
+    int new_face();
+    // adds pairs of twins at the end and returns id of the first edge, fields of the edges
+    // are set by the caller, so different pairs can be set on different threads
+    int add_edges(int pair_count);
+    // replaces edge with the given id
+    void set_edge(int edge_id, dceltype::edge e);
+    // removes edge with the given id and its twin
+    void remove_edge(int edge_id);
+    void remove_face(int face_id);
+    // removed edge has no origin, removed face has no edge
+    bool edge_removed(int edge_index) const;
+    bool face_removed(int face_id) const;
+    // vertex is not in the graph if it has no incident edge
+    bool vertex_removed(int vertex_index) const;
+
+    // creates edges and faces from triangles given as vertices ids in positive direction
+    // triangle i becomes face i+1, and edges without a twin in the triangles
+    // get their twins in the external face (0)
+    // dcel should have vertices only
+    void add_triangles(const std::vector<std::array<int,3>>& triangles);
+
+    // flags of faces are cached, they are valid for the faces classified
+    // after their last change, add_triangles classifies all faces,
+    // flags of a face that was never classified are not read, it is asserted
     // returns true if face with the given id is external (0)
     // or has point_minus_1 and/or point_minus_2
     bool imaginary(int face_id) const;
     // returns true if face with the given id constains both
     // point_minus_1 and point_minus_2
     bool bottom(int face_id) const;
+    // returns true if face with the given id is real and has an imaginary
+    // neighbour, so one of its edges is on the convex hull
+    bool hull_adjacent(int face_id) const;
+    // computes flags of the face with the given id from its vertices and neighbours
+    void classify(int face_id);
+    // computes flags of all faces in one pass
+    void classify();
 
     // returns edge id of edge that point lies on
     // edge is in face with given id
@@ -137,6 +224,11 @@ public:
     std::vector<int> points_ids(int face_id) const;
     // returns some vertex point in a face with the given id
     util::point point(int face_id) const;
+    // returns vertices ids of a triangular face with the given id,
+    // in the order of the edges starting from the edge of the face
+    std::array<int,3> triangle_ids(int face_id) const;
+    // returns points of a triangular face with real vertices only
+    std::array<util::point,3> triangle_points(int face_id) const;
 
     // edgeref is used for syntax sugar
     template <bool t>
@@ -149,27 +241,27 @@ public:
 
         int origin() const
         {
-            return d->m_edges[edge_index].origin();
+            return d->m_edge_origins[edge_index];
         }
 
         int twin() const
         {
-            return d->m_edges[edge_index].twin();
+            return dceltype::twin(edge_index+1);
         }
 
         int previous() const
         {
-            return d->m_edges[edge_index].previous();
+            return d->m_edge_previous[edge_index];
         }
 
         int next() const
         {
-            return d->m_edges[edge_index].next();
+            return d->m_edge_next[edge_index];
         }
 
         int face() const
         {
-            return d->m_edges[edge_index].face();
+            return d->m_edge_faces[edge_index];
         }
 
         int id() const
@@ -178,7 +270,6 @@ public:
         }
 
         void set_origin(int origin);
-        void set_twin(int twin);
         void set_previous(int previous);
         void set_next(int next);
         void set_face(int face);
@@ -213,13 +304,13 @@ public:
         {
             switch (relation) {
                 case edgerelation::twin:
-                    return {d->m_edges[edge_index].twin()-1, d};
+                    return {edge_index ^ 1, d};
                     break;
                 case edgerelation::previous:
-                    return {d->m_edges[edge_index].previous()-1, d};
+                    return {d->m_edge_previous[edge_index]-1, d};
                     break;
                 case edgerelation::next:
-                    return {d->m_edges[edge_index].next()-1, d};
+                    return {d->m_edge_next[edge_index]-1, d};
                     break;
                 default:
                     break;
@@ -235,6 +326,92 @@ public:
         std::conditional_t<t==true, const dcel*, dcel*> d;
     };
 
+    // range of edges of a face boundary (next) or edges out of a vertex (twin of previous),
+    // edges are visited until the first one is reached again, nothing is allocated
+    //
+    //   for (auto edge : d.face_edges(face_id)) { ... }
+    //
+    class edge_range {
+    public:
+        enum class circulation { face, vertex };
+
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = edgeref<true>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = edgeref<true>;
+
+            iterator(edgeref<true> edge, circulation c, bool started)
+                : m_edge(edge)
+                , m_circulation(c)
+                , m_started(started)
+            {}
+
+            edgeref<true> operator*() const
+            {
+                return m_edge;
+            }
+
+            iterator& operator++()
+            {
+                m_edge = (m_circulation == circulation::face) ? 
+                    m_edge | edgerelation::next : 
+                    m_edge | edgerelation::previous | edgerelation::twin;
+                m_started = true;
+                return *this;
+            }
+
+            bool operator==(const iterator& other) const
+            {
+                return m_edge.id() == other.m_edge.id() && m_started == other.m_started;
+            }
+
+            bool operator!=(const iterator& other) const
+            {
+                return !(*this == other);
+            }
+
+        private:
+            edgeref<true> m_edge;
+            circulation m_circulation;
+            // the first edge is the end once it is reached again
+            bool m_started;
+        };
+
+        edge_range(edgeref<true> first, circulation c)
+            : m_first(first)
+            , m_circulation(c)
+        {}
+
+        iterator begin() const
+        {
+            return {m_first, m_circulation, false};
+        }
+
+        iterator end() const
+        {
+            return {m_first, m_circulation, true};
+        }
+
+    private:
+        edgeref<true> m_first;
+        circulation m_circulation;
+    };
+
+    // edges of the face boundary starting from the edge of the face
+    edge_range face_edges(int face_id) const
+    {
+        return {face_edge(face_id), edge_range::circulation::face};
+    }
+
+    // edges out of the vertex starting from its incident edge, the vertex cannot be removed
+    edge_range vertex_edges(int vertex_id) const
+    {
+        return {edge(vertex(vertex_id-1).incident_edge()-1), edge_range::circulation::vertex};
+    }
+
     edgeref<false> edge(int i)
     {
         return {i, this};
@@ -256,14 +433,34 @@ public:
     }
 
 private:
+    // snapshot writes the arrays and the view copies them back
+    friend class snapshot;
+    friend class snapshottype::dcel_view;
+
     // returns true if edge is incident to the external face
     bool external_edge(int edge_index) const;
     // returns true if edge constains point_minus_1 or point_minus_2
     bool has_negative_vertex(int edge_index) const;
+    // add_direction with points of the ids that are already read
+    void add_direction(util::orientation_batch& batch, int source_point_id, util::point source, 
+                       int destination_point_id, util::point destination) const;
 
     std::vector<dceltype::vertex> m_vertices;
-    std::vector<dceltype::edge> m_edges;
+    // fields of edges are stored in separate arrays, so traversals read only
+    // the fields they need, edge i is at index i-1
+    std::vector<int> m_edge_origins;
+    std::vector<int> m_edge_previous;
+    std::vector<int> m_edge_next;
+    std::vector<int> m_edge_faces;
     std::vector<dceltype::face> m_faces;
+    // cached flags of faces, see classify
+    std::vector<std::uint8_t> m_face_flags;
+    // ids of removed edges and faces, edges are removed in pairs,
+    // the list has id of the first edge of the pair
+    std::vector<int> m_free_edges;
+    std::vector<int> m_free_faces;
+    // true if all vertices have integral coordinates
+    bool m_integral = true;
 };
 
 #endif /* DCEL_H */
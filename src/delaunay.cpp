@@ -1,18 +1,39 @@
 #include "delaunay.h"
+#include "divide_and_conquer.h"
+#include "spatial_sort.h"
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <iostream>
+#include <numeric>
+#include <stdexcept>
 
-delaunay::delaunay(const std::vector<util::point>& points)
-    : m_dcel(points)
+// expected number of history graph nodes per point: a split adds 3 nodes
+// and a flip 2, and there are about 3 flips per inserted point
+#define GRAPH_NODES_PER_POINT (9)
+
+delaunay::delaunay(const std::vector<util::point>& points, delaunaytype::options options)
+    : m_location(options.location)
+    , m_dcel(points)
 {
+    if (options.engine == delaunaytype::engine::divide_and_conquer) {
+        // there is no history graph, walk is used if points are added later
+        m_location = delaunaytype::point_location::walk;
+        init_dcel_divide_and_conquer(options.threads);
+        return;
+    }
+
     init_dcel();
-    init_graph();
+    if (history()) {
+        init_graph();
+    }
 
-    // first point is already added as it is a part of the biggest triangle
-    for (int i = 1; i < m_dcel.vertex_count(); ++i) {
+    for (int i : insertion_sequence(options.order)) {
         add_point(i);
     }
+
+    // flags are not used during the construction, so they are computed once
+    m_dcel.classify();
 }
 
 void delaunay::init_dcel()
@@ -24,31 +45,96 @@ void delaunay::init_dcel()
 
     // add 6 edges of the biggest triangle (1, point_minus_2, point_minus_1)
     // that contains all the points; there are 6 edges because
-    // each edge has its twin edge in dcel structure
-    // edge = {origin id, twin id, previous edge id, next edge id, face id}
-    m_dcel.add({1, 4, 3, 2, 1});
-    m_dcel.add({dceltype::point_minus_2, 6, 1, 3, 1});
-    m_dcel.add({dceltype::point_minus_1, 5, 2, 1, 1});
-    m_dcel.add({dceltype::point_minus_2, 1, 6, 5, 0});
-    m_dcel.add({1, 3, 4, 6, 0});
-    m_dcel.add({dceltype::point_minus_1, 2, 5, 4, 0});
+    // each edge has its twin edge in dcel structure, twins are 1-2, 3-4 and 5-6
+    // edge = {origin id, previous edge id, next edge id, face id}
+    m_dcel.add({1, 5, 3, 1});
+    m_dcel.add({dceltype::point_minus_2, 4, 6, 0});
+    m_dcel.add({dceltype::point_minus_2, 1, 5, 1});
+    m_dcel.add({dceltype::point_minus_1, 6, 2, 0});
+    m_dcel.add({dceltype::point_minus_1, 3, 1, 1});
+    m_dcel.add({1, 2, 4, 0});
 
     // add external face 
     // face = {incident edge id}
-    m_dcel.add(dceltype::face{4});
+    m_dcel.add(dceltype::face{2});
     // add first internal face
     m_dcel.add(dceltype::face{1});
 }
 
+void delaunay::init_dcel_divide_and_conquer(int threads)
+{
+    // first point (id = 1, index = 0) is the highest one, so it is 
+    // a vertex of the biggest triangle as in the incremental algorithm
+    m_dcel.set_highest_first();
+
+    std::vector<util::point> points;
+    points.reserve(m_dcel.vertex_count());
+    std::transform(m_dcel.vertices().cbegin(), m_dcel.vertices().cend(), std::back_inserter(points), 
+            [](const auto& v) { return v.point(); });
+
+    divide_and_conquer dc{points, threads};
+
+    // vertex id is index+1
+    auto triangles = dc.triangles();
+    for (auto& triangle : triangles) {
+        for (int& id : triangle) {
+            ++id;
+        }
+    }
+
+    // each convex hull edge forms an imaginary triangle with point_minus_2 or point_minus_1
+    //
+    //       point_minus_2 can see edges         point_minus_1 can see edges
+    //       from the highest point down         from the lowest point up
+    //       to the lowest point                 to the highest point
+    //
+    // hull edges are given in negative direction: (A,B) is an edge BA of the convex hull,
+    // and ABp is the imaginary triangle in positive direction
+    int lowest_id = 1;
+    for (auto [a, b] : dc.hull()) {
+        int p = (points[b] > points[a]) ? dceltype::point_minus_2 : dceltype::point_minus_1;
+        triangles.push_back({a+1, b+1, p});
+
+        if (points[a] < points[lowest_id-1]) {
+            lowest_id = a+1;
+        }
+    }
+
+    // the bottom triangle
+    triangles.push_back({dceltype::point_minus_2, dceltype::point_minus_1, lowest_id});
+
+    // boundary of all triangles is the biggest triangle (1, point_minus_2, point_minus_1)
+    m_dcel.add_triangles(triangles);
+}
+
 void delaunay::init_graph()
 {
     // add first node in the graph - 
     // the biggest triangle (1, point_minus_2, point_minus_1) that constains
     // all the poinst, and it represents the first internal face (1)
     // node = {(point1 id, point2 id, point3 id), face id}
+    m_graph.reserve(GRAPH_NODES_PER_POINT * m_dcel.vertex_count());
     m_graph.add(node({1, dceltype::point_minus_2, dceltype::point_minus_1}, 1));
 }
 
+std::vector<int> delaunay::insertion_sequence(delaunaytype::insertion_order order) const
+{
+    if (order == delaunaytype::insertion_order::input) {
+        // first point is already added as it is a part of the biggest triangle
+        std::vector<int> sequence(m_dcel.vertex_count()-1);
+        std::iota(sequence.begin(), sequence.end(), 1);
+        return sequence;
+    }
+
+    std::vector<util::point> points;
+    points.reserve(m_dcel.vertex_count());
+    std::transform(m_dcel.vertices().cbegin(), m_dcel.vertices().cend(), std::back_inserter(points), 
+            [](const auto& v) { return v.point(); });
+
+    // first point is already added as it is a part of the biggest triangle
+    return util::brio_order(points, 1);
+}
+
 delaunay::position delaunay::get_position(util::point point, int node_index) const
 {
     // triangle points ids
@@ -68,41 +154,419 @@ delaunay::position delaunay::get_position(util::point point, int node_index) con
             position::outside;
 }
 
+delaunay::position delaunay::face_position(util::point point, int face_id) const
+{
+    auto edge = m_dcel.face_edge(face_id);
+    int id1 = edge.origin();
+    int id2 = (edge | edgerelation::next).origin();
+    int id3 = (edge | edgerelation::previous).origin();
+
+    auto turn1 = m_dcel.get_direction(point, id1, id2);
+    auto turn2 = m_dcel.get_direction(point, id2, id3);
+    auto turn3 = m_dcel.get_direction(point, id3, id1);
+
+    return (turn1 == util::direction::positive && turn2 == util::direction::positive && turn3 == util::direction::positive) ?
+            position::strictly_interior :
+           (turn1 != util::direction::negative && turn2 != util::direction::negative && turn3 != util::direction::negative) ?
+            position::boundary :
+            position::outside;
+}
+
 int delaunay::find_node(util::point point) const
 {
     int current_index = 0;
     while (!m_graph[current_index].leaf()) {
-        const auto& children = m_graph[current_index].children();
-        auto it = std::find_if(children.cbegin(), children.cend(), [&](int child_index) { 
-                      return get_position(point, child_index) != position::outside;
-                  });
+        const auto& current = m_graph[current_index];
+        int i = 0;
+        if (m_location == delaunaytype::point_location::batched_history_dag) {
+            // directions of the point and edges of all children are evaluated in one batch,
+            // a child contains the point if none of its directions is negative,
+            // the point is in the current triangle, so the edges of it are not evaluated
+            util::orientation_batch batch;
+            std::array<unsigned,3> lanes;
+            for (int j = 0; j < current.children_count(); ++j) {
+                lanes[j] = m_dcel.add_directions(batch, m_graph[current.child(j)].vertices(), current.vertices());
+            }
+            unsigned negative = util::negative_directions(point, batch);
+            while (i < current.children_count() && (negative & lanes[i]) != 0) {
+                ++i;
+            }
+        }
+        else {
+            while (i < current.children_count() && get_position(point, current.child(i)) == position::outside) {
+                ++i;
+            }
+        }
         // there should be a triangle that constains the point at each level
-        assert(it != children.end());
-        current_index = *it;
+        assert(i < current.children_count());
+        current_index = current.child(i);
     }
 
     return current_index;
 }
 
+int delaunay::walk(util::point point)
+{
+    int face_id = m_last_face;
+    // face the walk came from, the edge shared with it doesn't have to be checked
+    int previous_face_id = -1;
+
+    while (true) {
+        auto edge = m_dcel.face_edge(face_id);
+
+        // start from a random edge of the triangle, so the walk cannot cycle
+        m_walk_state ^= m_walk_state << 13;
+        m_walk_state ^= m_walk_state >> 17;
+        m_walk_state ^= m_walk_state << 5;
+        for (unsigned i = m_walk_state % 3; i > 0; --i) {
+            edge = edge | edgerelation::next;
+        }
+
+        int next_face_id = -1;
+        for (int i = 0; i < 3 && next_face_id == -1; ++i) {
+            auto twin = edge | edgerelation::twin;
+            if (twin.face() != previous_face_id && 
+                m_dcel.get_direction(point, edge.origin(), twin.origin()) == util::direction::negative) {
+                // point is on the other side of the edge, cross it
+                // the point is always inside the biggest triangle, so the external face is never reached
+                next_face_id = twin.face();
+            }
+            edge = edge | edgerelation::next;
+        }
+
+        if (next_face_id == -1) {
+            // there is no edge with the point on the other side
+            return face_id;
+        }
+
+        previous_face_id = face_id;
+        face_id = next_face_id;
+    }
+}
+
+delaunaytype::changes delaunay::insert(util::point point)
+{
+    // point_minus_2 and point_minus_1 are defined relative to the highest point,
+    // so the biggest triangle would not contain a higher point
+    if (point > m_dcel.vertex(0).point()) {
+        throw std::invalid_argument("Point is higher than the highest point of the triangulation");
+    }
+
+    int face_id = locate(point);
+    auto ids = m_dcel.triangle_ids(face_id);
+    if (std::any_of(ids.cbegin(), ids.cend(), [&](int id) { return id > 0 && m_dcel.vertex(id-1).point() == point; })) {
+        throw std::invalid_argument("Point is already in the triangulation");
+    }
+
+    m_dcel.add(dceltype::vertex{point});
+    add_point(m_dcel.vertex_count()-1, face_id);
+    classify_changed_faces();
+
+    return get_changes(m_dcel.vertex_count());
+}
+
+delaunaytype::changes delaunay::remove(int vertex_id)
+{
+    if (vertex_id < 1 || vertex_id > m_dcel.vertex_count() || m_dcel.vertex_removed(vertex_id-1)) {
+        throw std::invalid_argument("Vertex is not in the triangulation");
+    }
+    if (vertex_id == 1) {
+        // point_minus_2 and point_minus_1 are defined relative to the highest point
+        throw std::invalid_argument("The highest vertex cannot be removed");
+    }
+
+    // triangles of removed vertex are not in the history graph anymore,
+    // so walk is used from now on
+    m_location = delaunaytype::point_location::walk;
+    m_graph = graph{};
+
+    m_changed_faces.clear();
+    m_new_faces.clear();
+    reduce_degree(vertex_id);
+    int face_id = remove_star(vertex_id);
+
+    // edges of the changed faces can be illegal
+    for (int id : m_changed_faces) {
+        if (m_dcel.face_removed(id)) {
+            continue;
+        }
+        auto edge = m_dcel.face_edge(id);
+        for (int i = 0; i < 3; ++i, edge = edge | edgerelation::next) {
+            m_flip_stack.push_back(edge.id());
+        }
+    }
+    legalize_all();
+
+    m_last_face = face_id;
+    classify_changed_faces();
+    return get_changes(vertex_id);
+}
+
+bool delaunay::move(const std::vector<util::point>& points)
+{
+    assert((int)points.size() == m_dcel.vertex_count());
+
+    // point_minus_2 and point_minus_1 are defined relative to the highest point
+    for (int i = 1; i < m_dcel.vertex_count(); ++i) {
+        if (!m_dcel.vertex_removed(i) && points[i] >= points[0]) {
+            return false;
+        }
+    }
+
+    // duplicates are found before anything is changed, so the triangulation is kept
+    std::vector<util::point> sorted_points;
+    sorted_points.reserve(m_dcel.vertex_count());
+    for (int i = 0; i < m_dcel.vertex_count(); ++i) {
+        if (!m_dcel.vertex_removed(i)) {
+            sorted_points.push_back(points[i]);
+        }
+    }
+    std::sort(sorted_points.begin(), sorted_points.end());
+    if (std::adjacent_find(sorted_points.cbegin(), sorted_points.cend()) != sorted_points.cend()) {
+        throw std::invalid_argument("Two vertices would be at the same point");
+    }
+
+    std::vector<util::point> old_points;
+    old_points.reserve(m_dcel.vertex_count());
+    for (int i = 0; i < m_dcel.vertex_count(); ++i) {
+        old_points.push_back(m_dcel.vertex(i).point());
+        if (!m_dcel.vertex_removed(i)) {
+            m_dcel.set_point(i, points[i]);
+        }
+    }
+
+    // flips repair a triangulation whose triangles are not inverted, so vertices of
+    // inverted triangles are moved back until there are no inverted triangles,
+    // and they are removed and added again at their points after the flips
+    std::vector<int> relocated;
+    std::vector<bool> moved_back(m_dcel.vertex_count(), false);
+    bool inverted = true;
+    while (inverted) {
+        inverted = false;
+        for (int face_id = 1; face_id < m_dcel.face_count(); ++face_id) {
+            if (m_dcel.face_removed(face_id)) {
+                continue;
+            }
+            auto ids = m_dcel.triangle_ids(face_id);
+            if (m_dcel.orientation(ids[0], ids[1], ids[2]) == util::direction::positive) {
+                continue;
+            }
+            inverted = true;
+            // the highest vertex cannot be removed, so it is moved back
+            // only if the other vertices of the triangle are already moved back
+            bool moved = false;
+            for (int id : ids) {
+                if (id > 1 && !moved_back[id-1]) {
+                    moved_back[id-1] = true;
+                    relocated.push_back(id);
+                    m_dcel.set_point(id-1, old_points[id-1]);
+                    moved = true;
+                }
+            }
+            if (!moved) {
+                moved_back[0] = true;
+                break;
+            }
+        }
+        if (moved_back[0]) {
+            break;
+        }
+    }
+    if (moved_back[0]) {
+        for (int i = 0; i < m_dcel.vertex_count(); ++i) {
+            m_dcel.set_point(i, old_points[i]);
+        }
+        return false;
+    }
+
+    // triangles in the history graph are not valid anymore,
+    // so walk is used from now on
+    m_location = delaunaytype::point_location::walk;
+    m_graph = graph{};
+
+    // any edge can be illegal, one edge of every pair of twins is checked
+    m_changed_faces.clear();
+    m_new_faces.clear();
+    for (int i = 0; i < m_dcel.edge_count(); i += 2) {
+        if (!m_dcel.edge_removed(i)) {
+            m_flip_stack.push_back(i+1);
+        }
+    }
+    legalize_all();
+    classify_changed_faces();
+
+    // all vertices are removed before any of them is added again, because the point
+    // of a vertex can be the old point of another relocated vertex,
+    // vertex keeps its id when it is added again
+    for (int vertex_id : relocated) {
+        remove(vertex_id);
+    }
+    for (int vertex_id : relocated) {
+        auto point = points[vertex_id-1];
+        int face_id = locate(point);
+        m_dcel.set_point(vertex_id-1, point);
+        add_point(vertex_id-1, face_id);
+        classify_changed_faces();
+    }
+
+    return true;
+}
+
+void delaunay::classify_changed_faces()
+{
+    // hull flag of a face depends on its neighbours, so they are classified too
+    for (int id : m_changed_faces) {
+        m_dcel.classify(id);
+        if (m_dcel.face_removed(id)) {
+            continue;
+        }
+        for (auto edge : m_dcel.face_edges(id)) {
+            m_dcel.classify((edge | edgerelation::twin).face());
+        }
+    }
+}
+
+delaunaytype::changes delaunay::get_changes(int vertex_id)
+{
+    delaunaytype::changes result;
+    result.vertex_id = vertex_id;
+
+    // a face can be changed by the split and by many flips
+    std::sort(m_changed_faces.begin(), m_changed_faces.end());
+    m_changed_faces.erase(std::unique(m_changed_faces.begin(), m_changed_faces.end()), m_changed_faces.end());
+
+    std::copy_if(m_changed_faces.cbegin(), m_changed_faces.cend(), std::back_inserter(result.created_faces), 
+            [&](int id) { return !m_dcel.face_removed(id); });
+    std::copy_if(m_changed_faces.cbegin(), m_changed_faces.cend(), std::back_inserter(result.destroyed_faces), 
+            [&](int id) { return std::find(m_new_faces.cbegin(), m_new_faces.cend(), id) == m_new_faces.cend(); });
+
+    return result;
+}
+
+void delaunay::reduce_degree(int vertex_id)
+{
+    //          U(i)                   U(i)
+    //          /|\                    / \
+    //         / | \                  /   \
+    //  U(i+1)   |   U(i-1)  -->  U(i+1)---U(i-1)
+    //         \ | /                  \   /
+    //          \|/                    \ /
+    //           V                      V
+    //
+    // edge V-U(i) can be flipped if V-U(i+1)-U(i)-U(i-1) is convex,
+    // there is always such edge when V has more than 3 neighbours
+    auto degree = [&]() {
+        auto star = m_dcel.vertex_edges(vertex_id);
+        return std::distance(star.begin(), star.end());
+    };
+
+    while (degree() > 3) {
+        auto edge = m_dcel.edge(m_dcel.vertex(vertex_id-1).incident_edge()-1);
+        while (true) {
+            int u = (edge | edgerelation::twin).origin();
+            int next_u = (edge | edgerelation::previous).origin();
+            int previous_u = (edge | edgerelation::twin | edgerelation::previous).origin();
+
+            if (m_dcel.orientation(previous_u, u, next_u) == util::direction::positive &&
+                m_dcel.orientation(next_u, vertex_id, previous_u) == util::direction::positive) {
+                flip_edge(edge);
+                break;
+            }
+            edge = edge | edgerelation::previous | edgerelation::twin;
+        }
+    }
+
+    // edges pushed by flips are checked after the vertex is removed
+    m_flip_stack.clear();
+}
+
+int delaunay::remove_star(int vertex_id)
+{
+    //         U1                     U1
+    //        /|\                    / \
+    //       / | \                  /   \
+    //      /  V  \       -->      /     \
+    //     / /   \ \              /       \
+    //    U2-------U0            U2-------U0
+    //
+    // edges of the first face are the new face, edges out of V are removed
+    std::array<int,3> out_edges;
+    std::array<int,3> outer_edges;
+    std::array<int,3> faces;
+
+    auto edge = m_dcel.edge(m_dcel.vertex(vertex_id-1).incident_edge()-1);
+    for (int i = 0; i < 3; ++i) {
+        out_edges[i] = edge.id();
+        outer_edges[i] = edge.next();
+        faces[i] = edge.face();
+        edge = edge | edgerelation::previous | edgerelation::twin;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        auto outer_edge = m_dcel.edge(outer_edges[i]-1);
+        outer_edge.set_next(outer_edges[(i+1)%3]);
+        outer_edge.set_previous(outer_edges[(i+2)%3]);
+        outer_edge.set_face(faces[0]);
+
+        // incident edge of U can be U-V
+        if (outer_edge.origin() > 0) {
+            m_dcel.vertex(outer_edge.origin()-1).set_incident_edge(outer_edges[i]);
+        }
+    }
+
+    // twin of an out edge is removed with it
+    for (int id : out_edges) {
+        m_dcel.remove_edge(id);
+    }
+    m_dcel.face(faces[0]).set_edge(outer_edges[0]);
+    m_dcel.remove_face(faces[1]);
+    m_dcel.remove_face(faces[2]);
+    m_dcel.vertex(vertex_id-1).set_incident_edge(-1);
+
+    m_changed_faces.insert(m_changed_faces.end(), faces.cbegin(), faces.cend());
+    return faces[0];
+}
+
+int delaunay::locate(util::point point)
+{
+    return history() ? m_graph[find_node(point)].face() : walk(point);
+}
+
+bool delaunay::history() const
+{
+    return m_location == delaunaytype::point_location::history_dag ||
+           m_location == delaunaytype::point_location::batched_history_dag;
+}
+
 void delaunay::add_point(int point_index)
+{
+    // get face that contains the point
+    add_point(point_index, locate(m_dcel.vertex(point_index).point()));
+}
+
+void delaunay::add_point(int point_index, int face_id)
 {
     auto point = m_dcel.vertex(point_index).point();
-    // get node index that contains the point
-    int node_index = find_node(point);
-    auto position = get_position(point, node_index);
+    m_changed_faces.clear();
+    m_new_faces.clear();
+
+    auto position = face_position(point, face_id);
     assert(position != position::outside);
 
     if (position == position::strictly_interior) {
         // point is strictly in the triangle
-        split_triangle_interior(point_index, node_index);
+        split_triangle_interior(point_index, face_id);
     }
     else {
         // point is on the triangle edge
-        split_triangle_boundary(point_index, node_index);
+        split_triangle_boundary(point_index, face_id);
     }
+
+    // the next point is likely to be close to this one
+    m_last_face = face_id;
 }
 
-void delaunay::split_triangle_interior(int point_index, int node_index)
+void delaunay::split_triangle_interior(int point_index, int face_id)
 {
     // D is a new point
     //
@@ -119,130 +583,132 @@ void delaunay::split_triangle_interior(int point_index, int node_index)
     //  CDB is the first new face
     //  ADC is the second new face
 
-    int face_id = m_graph[node_index].face();
-
     auto face_edge = m_dcel.face_edge(face_id);               // AB
     auto previous_edge = face_edge | edgerelation::previous;  // CA
     auto next_edge = face_edge | edgerelation::next;          // BC
 
-    int new_edge_id = m_dcel.edge_count()+1;
-    int new_face_id = m_dcel.face_count();
+    // ids of new edges and faces, removed ones are reused
+    // new edges are pairs of twins DA - AD, BD - DB and CD - DC
+    std::array<int,3> pair_ids{m_dcel.new_edge(), m_dcel.new_edge(), m_dcel.new_edge()};
+    std::array<int,6> new_edge_ids{pair_ids[0], pair_ids[1], pair_ids[1]+1, pair_ids[2], pair_ids[2]+1, pair_ids[0]+1};
+    std::array<int,2> new_face_ids{m_dcel.new_face(), m_dcel.new_face()};
+    m_new_faces.assign(new_face_ids.cbegin(), new_face_ids.cend());
+    m_changed_faces.insert(m_changed_faces.end(), {face_id, new_face_ids[0], new_face_ids[1]});
 
-    // add a new edge: new_edge_id (DA)
-    m_dcel.add(dceltype::edge{
+    // add a new edge: new_edge_ids[0] (DA)
+    m_dcel.set_edge(new_edge_ids[0], dceltype::edge{
         point_index+1,          // origin - D
-        new_edge_id+5,          // twin - AD
-        new_edge_id+1,          // previous - BD
+        new_edge_ids[1],        // previous - BD
         face_edge.id(),         // next - AB
         face_id});              // old face
 
-    // add a new edge: new_edge_id+1 (BD)
-    m_dcel.add(dceltype::edge{
+    // add a new edge: new_edge_ids[1] (BD)
+    m_dcel.set_edge(new_edge_ids[1], dceltype::edge{
         next_edge.origin(),     // origin - B
-        new_edge_id+2,          // twin - DB
         face_edge.id(),         // previous - AB
-        new_edge_id,            // next - DA
+        new_edge_ids[0],        // next - DA
         face_id});              // old face
 
-    // add a new edge: new_edge_id+2 (DB)
-    m_dcel.add(dceltype::edge{
+    // add a new edge: new_edge_ids[2] (DB)
+    m_dcel.set_edge(new_edge_ids[2], dceltype::edge{
         point_index+1,          // origin - D
-        new_edge_id+1,          // twin - BD
-        new_edge_id+3,          // previous - CD
+        new_edge_ids[3],        // previous - CD
         next_edge.id(),         // next - BC
-        new_face_id});          // the first new face
+        new_face_ids[0]});      // the first new face
 
-    // add a new edge: new_edge_id+3 (CD)
-    m_dcel.add(dceltype::edge{
+    // add a new edge: new_edge_ids[3] (CD)
+    m_dcel.set_edge(new_edge_ids[3], dceltype::edge{
         previous_edge.origin(), // origin - C
-        new_edge_id+4,          // twin - DC
         next_edge.id(),         // previous - BC
-        new_edge_id+2,          // next - DB
-        new_face_id});          // the first new face
+        new_edge_ids[2],        // next - DB
+        new_face_ids[0]});      // the first new face
 
-    // add a new edge: new_edge_id+4 (DC)
-    m_dcel.add(dceltype::edge{
+    // add a new edge: new_edge_ids[4] (DC)
+    m_dcel.set_edge(new_edge_ids[4], dceltype::edge{
         point_index+1,          // origin - D
-        new_edge_id+3,          // twin - CD
-        new_edge_id+5,          // previous - AD
+        new_edge_ids[5],        // previous - AD
         previous_edge.id(),     // next - CA
-        new_face_id+1});        // the second new face
+        new_face_ids[1]});      // the second new face
 
-    // add a new edge: new_edge_id+5 (AD)
-    m_dcel.add(dceltype::edge{
+    // add a new edge: new_edge_ids[5] (AD)
+    m_dcel.set_edge(new_edge_ids[5], dceltype::edge{
         face_edge.origin(),     // origin - A
-        new_edge_id,            // twin - DA
         previous_edge.id(),     // previous - CA
-        new_edge_id+4,          // next - DC
-        new_face_id+1});        // the second new face
+        new_edge_ids[4],        // next - DC
+        new_face_ids[1]});      // the second new face
 
     // incident edge of D is DA
-    m_dcel.vertex(point_index).set_incident_edge(new_edge_id);
+    m_dcel.vertex(point_index).set_incident_edge(new_edge_ids[0]);
 
     // update existing edges
     // AB previous is DA
-    face_edge.set_previous(new_edge_id);
+    face_edge.set_previous(new_edge_ids[0]);
     // AB next is BD
-    face_edge.set_next(new_edge_id+1);
+    face_edge.set_next(new_edge_ids[1]);
 
     // BC previous is DB
-    next_edge.set_previous(new_edge_id+2);
+    next_edge.set_previous(new_edge_ids[2]);
     // BC next is CD
-    next_edge.set_next(new_edge_id+3);
+    next_edge.set_next(new_edge_ids[3]);
     // BC face is the first new face
-    next_edge.set_face(new_face_id);
+    next_edge.set_face(new_face_ids[0]);
 
     // CA previous is DC
-    previous_edge.set_previous(new_edge_id+4);
+    previous_edge.set_previous(new_edge_ids[4]);
     // CA next is AD
-    previous_edge.set_next(new_edge_id+5);
+    previous_edge.set_next(new_edge_ids[5]);
     // CA face is the second new face
-    previous_edge.set_face(new_face_id+1);
+    previous_edge.set_face(new_face_ids[1]);
 
     // incident edge of the first new face is DB
-    m_dcel.add(dceltype::face{new_edge_id+2});
+    m_dcel.face(new_face_ids[0]).set_edge(new_edge_ids[2]);
     // incident edge of the second new face is DC
-    m_dcel.add(dceltype::face{new_edge_id+4});
-
-    // update the graph
-    int new_node_id = m_graph.size();
-    m_graph[node_index].set_children({new_node_id, new_node_id+1, new_node_id+2});
-
-    // insert three new nodes
-    auto node0 = node({
-        (face_edge /*AB*/ | edgerelation::next /*BD*/).origin(),          // B
-        (face_edge /*AB*/ | edgerelation::previous /*DA*/).origin(),      // D
-        face_edge.origin()},                                              // A
-        face_id);                                                         // old face
-
-    auto node1 = node({
-        (next_edge /*BC*/ | edgerelation::next /*CD*/).origin(),          // C
-        (next_edge /*BC*/ | edgerelation::previous /*DB*/).origin(),      // D
-        next_edge.origin()},                                              // B
-        new_face_id);                                                     // the first new face
-
-    auto node2 = node({
-        (previous_edge /*CA*/ | edgerelation::next /*AD*/).origin(),      // A
-        (previous_edge /*CA*/ | edgerelation::previous /*DC*/).origin(),  // D
-        previous_edge.origin()},                                          // C
-        new_face_id+1);                                                   // the second new face
-
-    m_graph.add(std::move(node0));
-    m_graph.add(std::move(node1));
-    m_graph.add(std::move(node2));
+    m_dcel.face(new_face_ids[1]).set_edge(new_edge_ids[4]);
+
+    if (history()) {
+        // update the graph
+        int node_index = m_graph.get_node(face_id);
+        int new_node_id = m_graph.size();
+        m_graph[node_index].set_children({new_node_id, new_node_id+1, new_node_id+2});
+
+        // insert three new nodes
+        auto node0 = node({
+            (face_edge /*AB*/ | edgerelation::next /*BD*/).origin(),          // B
+            (face_edge /*AB*/ | edgerelation::previous /*DA*/).origin(),      // D
+            face_edge.origin()},                                              // A
+            face_id);                                                         // old face
+
+        auto node1 = node({
+            (next_edge /*BC*/ | edgerelation::next /*CD*/).origin(),          // C
+            (next_edge /*BC*/ | edgerelation::previous /*DB*/).origin(),      // D
+            next_edge.origin()},                                              // B
+            new_face_ids[0]);                                                 // the first new face
+
+        auto node2 = node({
+            (previous_edge /*CA*/ | edgerelation::next /*AD*/).origin(),      // A
+            (previous_edge /*CA*/ | edgerelation::previous /*DC*/).origin(),  // D
+            previous_edge.origin()},                                          // C
+            new_face_ids[1]);                                                 // the second new face
+
+        m_graph.add(std::move(node0));
+        m_graph.add(std::move(node1));
+        m_graph.add(std::move(node2));
+    }
 
     // flip edges if needed
     // there is a theorem that newly added edges cannot be flipped now, so we don't need to check them now
-    // when one edge gets filpped, we will recursively check for other edges
-    // AB
-    try_flip(face_edge);
-    // CA
-    try_flip(previous_edge);
+    // when one edge gets filpped, other edges that can become illegal are pushed to the stack
+    // edges are pushed in reverse order, so AB is checked first
     // BC
-    try_flip(next_edge);
+    m_flip_stack.push_back(next_edge.id());
+    // CA
+    m_flip_stack.push_back(previous_edge.id());
+    // AB
+    m_flip_stack.push_back(face_edge.id());
+    legalize();
 }
 
-void delaunay::split_triangle_boundary(int point_index, int node_index)
+void delaunay::split_triangle_boundary(int point_index, int face_id)
 {
     // E is a new point
     //
@@ -259,12 +725,17 @@ void delaunay::split_triangle_boundary(int point_index, int node_index)
     //  EDA - the first old face
     //  CDE - the second old face
     //  EBC - the second new face
+    //  BD and DB become twins BE and EB
 
-    int new_edge_id = m_dcel.edge_count()+1;
-    int new_face_id = m_dcel.face_count();
+    // ids of new edges and faces, removed ones are reused
+    // new edges are pairs of twins ED - DE, AE - EA and CE - EC
+    std::array<int,3> pair_ids{m_dcel.new_edge(), m_dcel.new_edge(), m_dcel.new_edge()};
+    std::array<int,6> new_edge_ids{pair_ids[0], pair_ids[1], pair_ids[1]+1, pair_ids[0]+1, pair_ids[2], pair_ids[2]+1};
+    std::array<int,2> new_face_ids{m_dcel.new_face(), m_dcel.new_face()};
+    m_new_faces.assign(new_face_ids.cbegin(), new_face_ids.cend());
 
     // get edge id where new point is collinear
-    int collinear_edge_id = m_dcel.collinear_edge_id(point_index, m_graph[node_index].face());
+    int collinear_edge_id = m_dcel.collinear_edge_id(point_index, face_id);
     assert(collinear_edge_id != -1);
 
     auto collinear_edge = m_dcel.edge(collinear_edge_id-1);     // BD
@@ -272,10 +743,11 @@ void delaunay::split_triangle_boundary(int point_index, int node_index)
 
     int first_old_face = collinear_edge.face();
     int second_old_face = collinear_edge2.face();
+    m_changed_faces.insert(m_changed_faces.end(), {first_old_face, second_old_face, new_face_ids[0], new_face_ids[1]});
 
     // nodes ids that will be updated
-    int old_node1 = m_graph.get_node(first_old_face);  // ABD
-    int old_node2 = m_graph.get_node(second_old_face); // BCD
+    int old_node1 = history() ? m_graph.get_node(first_old_face) : -1;  // ABD
+    int old_node2 = history() ? m_graph.get_node(second_old_face) : -1; // BCD
 
     // ------------------------------- update ABD ----------------------------------------
     //  D ------- C     D ------- C
@@ -288,72 +760,69 @@ void delaunay::split_triangle_boundary(int point_index, int node_index)
     auto prev_edge = collinear_edge | edgerelation::previous; // AB
     auto next_edge = collinear_edge | edgerelation::next;     // DA
 
-    // add a new edge: new_edge_id (ED)
-    m_dcel.add(dceltype::edge(
+    // add a new edge: new_edge_ids[0] (ED)
+    m_dcel.set_edge(new_edge_ids[0], dceltype::edge(
         point_index+1,          // origin - E
-        collinear_edge2.id(),   // twin - DB (it will be updated to DE later)
-        new_edge_id+1,          // previous - AE
+        new_edge_ids[1],        // previous - AE
         next_edge.id(),         // next - DA
         first_old_face));       // the first old face
 
-    // add a new edge: new_edge_id+1 (AE)
-    m_dcel.add(dceltype::edge(
+    // add a new edge: new_edge_ids[1] (AE)
+    m_dcel.set_edge(new_edge_ids[1], dceltype::edge(
         prev_edge.origin(),    // origin - A
-        new_edge_id+2,         // twin - EA
         next_edge.id(),        // previous - DA
-        new_edge_id,           // next - ED
+        new_edge_ids[0],       // next - ED
         first_old_face));      // the first old face
 
-    // add a new edge: new_edge_id+2 (EA)
-    m_dcel.add(dceltype::edge(
+    // add a new edge: new_edge_ids[2] (EA)
+    m_dcel.set_edge(new_edge_ids[2], dceltype::edge(
         point_index+1,         // origin - E
-        new_edge_id+1,         // twin - AE
         collinear_edge.id(),   // previous - BD (it will be updated to BE later)
         prev_edge.id(),        // next - AB
-        new_face_id));         // the new face
+        new_face_ids[0]));     // the new face
 
     // incident edge of E is EA
-    m_dcel.vertex(point_index).set_incident_edge(new_edge_id+2);
+    m_dcel.vertex(point_index).set_incident_edge(new_edge_ids[2]);
 
     // update BD to BE by changing next edge of BD to be EA
-    collinear_edge.set_next(new_edge_id+2);
-    // BE twin is EB
-    collinear_edge.set_twin(new_edge_id+3);
+    collinear_edge.set_next(new_edge_ids[2]);
     // BE belongs to new face now
-    collinear_edge.set_face(new_face_id);
+    collinear_edge.set_face(new_face_ids[0]);
 
     // DA next is AE
-    next_edge.set_next(new_edge_id+1);
+    next_edge.set_next(new_edge_ids[1]);
     // DA previous is ED
-    next_edge.set_previous(new_edge_id);
+    next_edge.set_previous(new_edge_ids[0]);
 
     // AB previous is EA
-    prev_edge.set_previous(new_edge_id+2);
+    prev_edge.set_previous(new_edge_ids[2]);
     // AB belongs to new face now
-    prev_edge.set_face(new_face_id);
+    prev_edge.set_face(new_face_ids[0]);
 
     // update the face
     // incident edge of the old face is AE
-    m_dcel.face(first_old_face).set_edge(new_edge_id+1);
+    m_dcel.face(first_old_face).set_edge(new_edge_ids[1]);
 
     // add new face
     // incident edge of the new face is EA
-    m_dcel.add(dceltype::face(new_edge_id+2));
-
-    // update the graph
-    m_graph[old_node1].set_children({m_graph.size(), m_graph.size()+1});
-
-    m_graph.add(node(
-        {(collinear_edge /*BE*/ | edgerelation::previous /*AB*/).origin(),  // A
-         collinear_edge.origin(),                                           // B
-         (collinear_edge /*BE*/ | edgerelation::next /*EA*/).origin()},     // E
-        new_face_id));                                                      // the first new face
-
-    m_graph.add(node(
-        {(next_edge /*DA*/ | edgerelation::previous /*ED*/).origin(),       // E
-          next_edge.origin(),                                               // D
-         (next_edge /*DA*/ | edgerelation::next /*AE*/).origin()},          // A
-        first_old_face));                                                   // the first old face
+    m_dcel.face(new_face_ids[0]).set_edge(new_edge_ids[2]);
+
+    if (history()) {
+        // update the graph
+        m_graph[old_node1].set_children({m_graph.size(), m_graph.size()+1});
+
+        m_graph.add(node(
+            {(collinear_edge /*BE*/ | edgerelation::previous /*AB*/).origin(),  // A
+             collinear_edge.origin(),                                           // B
+             (collinear_edge /*BE*/ | edgerelation::next /*EA*/).origin()},     // E
+            new_face_ids[0]));                                                  // the first new face
+
+        m_graph.add(node(
+            {(next_edge /*DA*/ | edgerelation::previous /*ED*/).origin(),       // E
+              next_edge.origin(),                                               // D
+             (next_edge /*DA*/ | edgerelation::next /*AE*/).origin()},          // A
+            first_old_face));                                                   // the first old face
+    }
 
 
     // ------------------------------- update BCD ----------------------------------------
@@ -366,87 +835,142 @@ void delaunay::split_triangle_boundary(int point_index, int node_index)
     //  A ------- B     A ------- B
     auto prev_edge2 = collinear_edge2 | edgerelation::previous; // CD
     auto next_edge2 = collinear_edge2 | edgerelation::next;     // BC
+    auto new_edge = m_dcel.edge(new_edge_ids[3]-1);             // DE
+
+    // add a new edge: new_edge_ids[3] (DE)
+    m_dcel.set_edge(new_edge_ids[3], dceltype::edge(
+        collinear_edge2.origin(), // origin - D
+        prev_edge2.id(),          // previous - CD
+        new_edge_ids[5],          // next - EC
+        second_old_face));        // the second old face
+
+    // add a new edge: new_edge_ids[4] (CE)
+    m_dcel.set_edge(new_edge_ids[4], dceltype::edge(
+        prev_edge2.origin(),      // origin - C
+        next_edge2.id(),          // previous - BC
+        collinear_edge2.id(),     // next - EB
+        new_face_ids[1]));        // the second new face
+
+    // add a new edge: new_edge_ids[5] (EC)
+    m_dcel.set_edge(new_edge_ids[5], dceltype::edge(
+        point_index+1,            // origin - E
+        new_edge_ids[3],          // previous - DE
+        prev_edge2.id(),          // next - CD
+        second_old_face));        // the second old face
+
+    // incident edge of D can be DB
+    if (m_dcel.vertex(new_edge.origin()-1).incident_edge() == collinear_edge2.id()) {
+        m_dcel.vertex(new_edge.origin()-1).set_incident_edge(new_edge_ids[3]);
+    }
 
-    // add a new edge: new_edge_id+3 (EB)
-    m_dcel.add(dceltype::edge(
-        point_index+1,        // origin - E
-        collinear_edge.id(),  // twin - BE
-        new_edge_id+4,        // previous - CE
-        next_edge2.id(),      // next - BC
-        new_face_id+1));      // the second new face
-
-    // add a new edge: new_edge_id+4 (CE)
-    m_dcel.add(dceltype::edge(
-        prev_edge2.origin(),  // origin - C
-        new_edge_id+5,        // twin - EC
-        next_edge2.id(),      // previous - BC
-        new_edge_id+3,        // next - EB
-        new_face_id+1));      // the second new face
-
-    // add a new edge: new_edge_id+5 (EC)
-    m_dcel.add(dceltype::edge(
-        point_index+1,        // origin - E
-        new_edge_id+4,        // twin - CE
-        collinear_edge2.id(), // previous - DB (it will be updated to DE later)
-        prev_edge2.id(),      // next - CD
-        second_old_face));    // the second old face
-
-    // update DB to DE by changing next edge of DB to be EC
-    collinear_edge2.set_next(new_edge_id+5);
-    // DE twin is ED
-    collinear_edge2.set_twin(new_edge_id);
+    // update DB to EB, it is the twin of BE
+    // EB origin is E
+    collinear_edge2.set_origin(point_index+1);
+    // EB previous is CE
+    collinear_edge2.set_previous(new_edge_ids[4]);
+    // EB belongs to the second new face now
+    collinear_edge2.set_face(new_face_ids[1]);
 
     //  BC previous is EB
-    next_edge2.set_previous(new_edge_id+3);
+    next_edge2.set_previous(collinear_edge2.id());
     //  BC next is CE
-    next_edge2.set_next(new_edge_id+4);
+    next_edge2.set_next(new_edge_ids[4]);
     //  BC face is the second new face
-    next_edge2.set_face(new_face_id+1);
+    next_edge2.set_face(new_face_ids[1]);
 
     // CD prevous is EC
-    prev_edge2.set_previous(new_edge_id+5);
+    prev_edge2.set_previous(new_edge_ids[5]);
+    // CD next is DE
+    prev_edge2.set_next(new_edge_ids[3]);
 
     // update the face
     // edge in the second old face is EC 
-    m_dcel.face(second_old_face).set_edge(new_edge_id+5);
+    m_dcel.face(second_old_face).set_edge(new_edge_ids[5]);
 
     // add new face
     // edge in the second new face is CE
-    m_dcel.add(dceltype::face{new_edge_id+4});
-
-    // update the graph
-    m_graph[old_node2].set_children({m_graph.size(), m_graph.size()+1});
-
-    m_graph.add(node(
-        {(collinear_edge2 /*DE*/ | edgerelation::previous /*CD*/).origin(), // C
-         collinear_edge2.origin(),                                          // D
-         (collinear_edge2 /*DE*/ | edgerelation::next /*EC*/).origin()},    // E
-        second_old_face));                                                  // the second old face
-
-    m_graph.add(node(
-        {(next_edge2 /*BC*/ | edgerelation::previous /*EB*/).origin(),      // E
-         next_edge2.origin(),                                               // B
-         (next_edge2 /*BC*/ | edgerelation::next /*CE*/).origin()},         // C
-        new_face_id+1));                                                    // the second new face
+    m_dcel.face(new_face_ids[1]).set_edge(new_edge_ids[4]);
+
+    if (history()) {
+        // update the graph
+        m_graph[old_node2].set_children({m_graph.size(), m_graph.size()+1});
+
+        m_graph.add(node(
+            {(new_edge /*DE*/ | edgerelation::previous /*CD*/).origin(),        // C
+             new_edge.origin(),                                                 // D
+             (new_edge /*DE*/ | edgerelation::next /*EC*/).origin()},           // E
+            second_old_face));                                                  // the second old face
+
+        m_graph.add(node(
+            {(next_edge2 /*BC*/ | edgerelation::previous /*EB*/).origin(),      // E
+             next_edge2.origin(),                                               // B
+             (next_edge2 /*BC*/ | edgerelation::next /*CE*/).origin()},         // C
+            new_face_ids[1]));                                                  // the second new face
+    }
 
     // flip edges if needed
     // there is a theorem that newly added edges cannot be flipped now, so we don't need to check them now
-    // when one edge gets filpped, we will recursively check for other edges
-    // AB
-    try_flip(prev_edge);
-    // DA
-    try_flip(next_edge);
-    // CD
-    try_flip(prev_edge2);
+    // when one edge gets filpped, other edges that can become illegal are pushed to the stack
+    // edges are pushed in reverse order, so AB is checked first
     // BC
-    try_flip(next_edge2);
+    m_flip_stack.push_back(next_edge2.id());
+    // CD
+    m_flip_stack.push_back(prev_edge2.id());
+    // DA
+    m_flip_stack.push_back(next_edge.id());
+    // AB
+    m_flip_stack.push_back(prev_edge.id());
+    legalize();
+}
+
+void delaunay::legalize()
+{
+    int flips = 0;
+
+    while (!m_flip_stack.empty()) {
+        int edge_id = m_flip_stack.back();
+        m_flip_stack.pop_back();
+
+        if (illegal(edge_id)) {
+            flip_edge(m_dcel.edge(edge_id-1));
+            ++flips;
+        }
+    }
+
+    ++m_statistics.insertions;
+    m_statistics.flips += flips;
+    m_statistics.last_insertion_flips = flips;
+    m_statistics.max_insertion_flips = std::max(m_statistics.max_insertion_flips, flips);
+}
+
+void delaunay::legalize_all()
+{
+    int flips = 0;
+
+    while (!m_flip_stack.empty()) {
+        int edge_id = m_flip_stack.back();
+        m_flip_stack.pop_back();
+
+        if (illegal(edge_id)) {
+            auto edge = m_dcel.edge(edge_id-1);
+            // flip_edge pushes two edges of the quadrilateral, push the other two
+            flip_edge(edge);
+            m_flip_stack.push_back(edge.next());
+            m_flip_stack.push_back((edge | edgerelation::twin).previous());
+            ++flips;
+        }
+    }
+
+    m_statistics.flips += flips;
 }
 
-void delaunay::try_flip(dcel::edgeref<false> edge)
+bool delaunay::illegal(int edge_id) const
 {
+    auto edge = m_dcel.edge(edge_id-1);
+
     if (edge.external()) {
         // external edge cannot be flipped
-        return;
+        return false;
     }
 
     //        C
@@ -494,10 +1018,10 @@ void delaunay::try_flip(dcel::edgeref<false> edge)
                     // p_minus_2----b
                     // don't let p_minus_2-c to go inside convex hull, 
                     // flip p_minus_2-c to get b-d
-                    (d_point.get_direction(b_point, c_point) == util::direction::positive) : 
+                    (m_dcel.direction(d_point, b_point, c_point) == util::direction::positive) : 
                     // don't let p_minus_1-c to go inside convex hull, 
                     // flip p_minus_1-c to get b-d
-                    (d_point.get_direction(b_point, c_point) == util::direction::negative);
+                    (m_dcel.direction(d_point, b_point, c_point) == util::direction::negative);
             }
             else {
                 // C is negative -> A is positive
@@ -506,10 +1030,10 @@ void delaunay::try_flip(dcel::edgeref<false> edge)
                 flip = (c == dceltype::point_minus_2) ?
                     // don't let p_minus_2-a to go inside convex hull, 
                     // flip p_minus_2-a to get b-d
-                    (d_point.get_direction(b_point, a_point) == util::direction::positive) :
+                    (m_dcel.direction(d_point, b_point, a_point) == util::direction::positive) :
                     // don't let p_minus_1-a to go inside convex hull, 
                     // flip p_minus_1-a to get b-d
-                    (d_point.get_direction(b_point, a_point) == util::direction::negative);
+                    (m_dcel.direction(d_point, b_point, a_point) == util::direction::negative);
             }
         }
     }
@@ -523,13 +1047,11 @@ void delaunay::try_flip(dcel::edgeref<false> edge)
             auto b_point = (edge | edgerelation::twin | edgerelation::previous).point();
 
             // check if b is strictly in the circle defined by a-c-d
-            flip = b_point.in_circle(a_point,c_point,d_point);
+            flip = m_dcel.in_circle(b_point, a_point, c_point, d_point);
         }
     }
 
-    if (flip) {
-        flip_edge(edge);
-    }
+    return flip;
 }
 
 void delaunay::flip_edge(dcel::edgeref<false> edge)
@@ -548,9 +1070,11 @@ void delaunay::flip_edge(dcel::edgeref<false> edge)
     // edge - AC
     
     auto twin = edge | edgerelation::twin; // CA
+    m_changed_faces.push_back(edge.face());
+    m_changed_faces.push_back(twin.face());
 
-    int old_node1 = m_graph.get_node(edge.face());
-    int old_node2 = m_graph.get_node(twin.face());
+    int old_node1 = history() ? m_graph.get_node(edge.face()) : -1;
+    int old_node2 = history() ? m_graph.get_node(twin.face()) : -1;
 
     if (edge.origin() > 0) {
         // if A is positive update its incident edge to be AB
@@ -623,28 +1147,30 @@ void delaunay::flip_edge(dcel::edgeref<false> edge)
     // incident edge of face 2 is DB
     m_dcel.face(twin.face()).set_edge(edge.twin());
 
-    // update the graph
-    m_graph[old_node1].set_children({m_graph.size(), m_graph.size()+1});
-    m_graph[old_node2].set_children({m_graph.size(), m_graph.size()+1});
-
-    // insert two new nodes
-    m_graph.add(node({
-        (edge | edgerelation::previous).origin(),  // A
-        edge.origin(),                             // B
-        (edge | edgerelation::next).origin()},     // D
-        edge.face()));                             // face 1
-
-    m_graph.add(node(
-        {(twin | edgerelation::previous).origin(), // C
-        (edge | edgerelation::twin).origin(),      // D
-        (twin | edgerelation::next).origin()},     // B
-        twin.face()));                             // face 2
+    if (history()) {
+        // update the graph
+        m_graph[old_node1].set_children({m_graph.size(), m_graph.size()+1});
+        m_graph[old_node2].set_children({m_graph.size(), m_graph.size()+1});
+
+        // insert two new nodes
+        m_graph.add(node({
+            (edge | edgerelation::previous).origin(),  // A
+            edge.origin(),                             // B
+            (edge | edgerelation::next).origin()},     // D
+            edge.face()));                             // face 1
+
+        m_graph.add(node(
+            {(twin | edgerelation::previous).origin(), // C
+            (edge | edgerelation::twin).origin(),      // D
+            (twin | edgerelation::next).origin()},     // B
+            twin.face()));                             // face 2
+    }
 
-    // recursively check edges that can be illegal
-    // AB
-    try_flip(edge | edgerelation::previous);
+    // check edges that can be illegal now, AB is checked first
     // BC
-    try_flip(twin | edgerelation::next);
+    m_flip_stack.push_back((twin | edgerelation::next).id());
+    // AB
+    m_flip_stack.push_back((edge | edgerelation::previous).id());
 }
 
 std::vector<double> delaunay::range() const
@@ -666,6 +1192,9 @@ std::vector<util::line_segment> delaunay::get_edges() const
     std::vector<util::line_segment> result;
     // face 0 is external face
     for (int face_index = 1; face_index < m_dcel.face_count(); ++face_index) {
+        if (m_dcel.face_removed(face_index)) {
+            continue;
+        }
         auto current_edge = m_dcel.edge(m_dcel.face(face_index).edge()-1);
         int start_id = current_edge.id();
 
@@ -695,3 +1224,18 @@ const dcel& delaunay::triangulation() const
 {
     return m_dcel;
 }
+
+triangle_mesh delaunay::mesh() const
+{
+    return triangle_mesh(m_dcel);
+}
+
+const delaunaytype::statistics& delaunay::statistics() const
+{
+    return m_statistics;
+}
+
+const graph& delaunay::history_graph() const
+{
+    return m_graph;
+}
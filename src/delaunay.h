@@ -3,14 +3,98 @@
 
 #include "graph.h"
 #include "dcel.h"
+#include "triangle_mesh.h"
 #include "utility.h"
 
+namespace delaunaytype {
+    // order in which input points are added to the triangulation
+    enum class insertion_order {
+        // points are added in the input order
+        input,
+        // biased randomized insertion order with rounds sorted along the hilbert curve,
+        // consecutive points are close to each other so point location and flips
+        // touch the part of the triangulation that was just used
+        brio
+    };
+
+    // how the triangle that contains a new point is found
+    enum class point_location {
+        // descend the history graph of all triangles ever created,
+        // children are checked one by one until one contains the point
+        history_dag,
+        // descend the history graph, directions of the point and edges of all children
+        // of a node are evaluated in one vectorized batch, every child is read,
+        // so it is slower than history_dag when the search is bound by the loads
+        batched_history_dag,
+        // remembering stochastic walk across triangles starting from the last created one,
+        // the history graph is not built at all
+        walk
+    };
+
+    // algorithm that constructs the triangulation
+    enum class engine {
+        // points are added one by one, insertion order and point location are used
+        incremental,
+        // guibas-stolfi divide and conquer, O(n log n) in the worst case
+        divide_and_conquer
+    };
+
+    struct options {
+        insertion_order order = insertion_order::input;
+        point_location location = point_location::history_dag;
+        delaunaytype::engine engine = engine::incremental;
+        // number of threads used by the divide and conquer engine,
+        // the triangulation is the same for any number of threads
+        int threads = 1;
+    };
+
+    // counters of the incremental construction
+    struct statistics {
+        // number of points added by the incremental algorithm
+        int insertions = 0;
+        // number of flipped edges
+        long long flips = 0;
+        // number of edges flipped while adding the last point
+        int last_insertion_flips = 0;
+        // maximum number of edges flipped while adding one point
+        int max_insertion_flips = 0;
+    };
+
+    // result of adding a point to or removing a vertex from the built triangulation
+    using changes = dceltype::changes;
+}
+
 class delaunay {
-    // incremental delaunay triangulation algorithm
+    // delaunay triangulation, constructed by the engine given in options
+    // incremental algorithm is the default one
 public:
-    delaunay(const std::vector<util::point>& points);
+    delaunay(const std::vector<util::point>& points, delaunaytype::options options = {});
 
     const dcel& triangulation() const;
+    // returns the triangulation as triangles with neighbours, triangles are
+    // the faces in the order of face ids, including the imaginary ones
+    triangle_mesh mesh() const;
+    const delaunaytype::statistics& statistics() const;
+    // history graph of the incremental construction, it is empty if the graph
+    // is not used for point location and it is discarded by insert, remove and move
+    const graph& history_graph() const;
+
+    // adds a point to the triangulation, existing faces are updated by splits and flips
+    // point cannot be higher than the highest point the triangulation was built with
+    // throws std::invalid_argument if the point is higher or already in the triangulation
+    delaunaytype::changes insert(util::point point);
+    // removes a vertex from the triangulation, only the hole around it is triangulated again
+    // vertex id is kept, so ids of the other vertices don't change
+    // the highest vertex (id 1) cannot be removed
+    // throws std::invalid_argument if the vertex cannot be removed
+    delaunaytype::changes remove(int vertex_id);
+    // moves vertex with id i to points[i-1], points of removed vertices are not used,
+    // the triangulation is repaired by flips, so it is cheap for small moves, vertices
+    // of triangles that would be inverted are removed and added again with the same ids
+    // returns false and doesn't move the vertices if the highest vertex would not be
+    // the highest one anymore or one of its triangles would be inverted
+    // throws std::invalid_argument and doesn't move the vertices if two vertices would be at the same point
+    bool move(const std::vector<util::point>& points);
 
     // returns edges of the triangulation without 
     // imaginary points point_minus_1 and point_minus_2
@@ -26,28 +110,73 @@ private:
     void init_dcel();
     // init graph structure with the biggest triangle
     void init_graph();
+    // init dcel structure with the triangulation constructed by divide and conquer algorithm
+    // real triangles are surrounded by imaginary triangles, so the layout is the same
+    // as the one constructed by the incremental algorithm
+    void init_dcel_divide_and_conquer(int threads);
+    // returns indices of points to add in the order given by options
+    // first point is skipped as it is a part of the biggest triangle
+    std::vector<int> insertion_sequence(delaunaytype::insertion_order order) const;
 
     enum class position { strictly_interior, boundary, outside };
-    // returns position of point in a triangle that is stored
-    // in a node with the given node index
+    // returns position of point in a triangle with the given node index
     position get_position(util::point point, int node_index) const;
+    // returns position of point in a triangle with the given face id
+    position face_position(util::point point, int face_id) const;
     // returns node index that has a triangle which contains the point
     int find_node(util::point point) const;
+    // returns id of a face that contains the point,
+    // walks from the last created face to the point
+    int walk(util::point point);
+    // returns id of a face that contains the point
+    int locate(util::point point);
+    // returns true if the history graph is used for point location
+    bool history() const;
     // add new point to the current triangulation
     // when all points are added, we will have delaunay triangulation
     void add_point(int point_index);
+    // add new point that is in the face with the given id
+    void add_point(int point_index, int face_id);
 
     // split the triangle when point is strictly inside the triangle
-    // node_index - index of node in a graph that contains the triangle
-    // that is to be splitted
-    void split_triangle_interior(int point_index, int node_index);
+    // face_id - id of face that is to be splitted
+    void split_triangle_interior(int point_index, int face_id);
     // split the triangle when point is on the triangle boundary
-    // node_index - index of node in a graph that contains the triangle
-    // that is to be splitted
-    void split_triangle_boundary(int point_index, int node_index);
+    // face_id - id of face that is to be splitted
+    void split_triangle_boundary(int point_index, int face_id);
 
-    void try_flip(dcel::edgeref<false> edge);
+    // flips illegal edges from the flip stack until the stack is empty,
+    // flipping an edge pushes the edges that can become illegal
+    void legalize();
+    // returns true if edge with the given id should be flipped
+    bool illegal(int edge_id) const;
     void flip_edge(dcel::edgeref<false> edge);
+    // flips edges out of the vertex until it has 3 neighbours
+    void reduce_degree(int vertex_id);
+    // removes the vertex with 3 neighbours and merges its faces into one
+    // returns id of the merged face
+    int remove_star(int vertex_id);
+    // flips illegal edges from the flip stack until the stack is empty,
+    // flipping an edge pushes all edges of its quadrilateral
+    void legalize_all();
+    // updates cached flags of the faces changed by the last insertion or removal
+    void classify_changed_faces();
+    // returns changes from the faces changed by the last insertion or removal
+    delaunaytype::changes get_changes(int vertex_id);
+
+    delaunaytype::point_location m_location;
+    // face where the next walk starts
+    int m_last_face = 1;
+    // state of the random generator that picks the first edge tested in a walk
+    unsigned m_walk_state = 1;
+    // ids of edges that are to be checked by legalize,
+    // kept between insertions so its memory is reused
+    std::vector<int> m_flip_stack;
+    delaunaytype::statistics m_statistics;
+    // ids of faces changed by the last insertion or removal, can contain duplicates
+    std::vector<int> m_changed_faces;
+    // ids of faces added by the last insertion
+    std::vector<int> m_new_faces;
 
     graph m_graph; 
     dcel m_dcel;
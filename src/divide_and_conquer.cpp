@@ -0,0 +1,318 @@
+#include "divide_and_conquer.h"
+#include "predicates.h"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+// part of the triangulation with fewer points is triangulated on the current thread
+#define PARALLEL_MIN_POINTS (256)
+
+divide_and_conquer::divide_and_conquer(const std::vector<util::point>& points, int threads)
+    : m_points(points)
+    , m_integral(std::all_of(points.cbegin(), points.cend(), [](util::point p) { return util::integral(p); }))
+    , m_sorted_ids(points.size())
+{
+    if (points.size() < 3) {
+        throw std::runtime_error("Minimum number of points is 3");
+    }
+
+    std::iota(m_sorted_ids.begin(), m_sorted_ids.end(), 0);
+    std::sort(m_sorted_ids.begin(), m_sorted_ids.end(), [&](int lhs, int rhs) {
+        return points[lhs].x() < points[rhs].x() || (points[lhs].x() == points[rhs].x() && points[lhs].y() < points[rhs].y());
+    });
+
+    // there are at most 3n-6 edges in the triangulation, merging creates and deletes more
+    m_edges.reserve(8*points.size());
+    m_hull_edge = triangulate(m_edges, 0, points.size(), std::max(threads, 1)).first;
+}
+
+std::pair<int,int> divide_and_conquer::triangulate(quad_edges& edges, int begin, int end, int threads) const
+{
+    int count = end - begin;
+
+    if (count == 2) {
+        int a = edges.make_edge(m_sorted_ids[begin], m_sorted_ids[begin+1]);
+        return {a, edges.sym(a)};
+    }
+
+    if (count == 3) {
+        int s1 = m_sorted_ids[begin];
+        int s2 = m_sorted_ids[begin+1];
+        int s3 = m_sorted_ids[begin+2];
+
+        // s1 - s2 - s3 path
+        int a = edges.make_edge(s1, s2);
+        int b = edges.make_edge(s2, s3);
+        edges.splice(edges.sym(a), b);
+
+        // close the triangle
+        if (ccw(s1, s2, s3)) {
+            edges.connect(b, a);
+            return {a, edges.sym(b)};
+        }
+        if (ccw(s1, s3, s2)) {
+            int c = edges.connect(b, a);
+            return {edges.sym(c), c};
+        }
+
+        // points are collinear
+        return {a, edges.sym(b)};
+    }
+
+    // ldo - ccw convex hull edge out of the leftmost point of the left half
+    // ldi - cw convex hull edge out of the rightmost point of the left half
+    // rdi - ccw convex hull edge out of the leftmost point of the right half
+    // rdo - cw convex hull edge out of the rightmost point of the right half
+    int middle = begin + count/2;
+
+    if (threads > 1 && count >= PARALLEL_MIN_POINTS) {
+        // triangulate the right strip on a new thread with its own edges
+        quad_edges right_edges;
+        std::pair<int,int> right_hull;
+        std::thread right_thread([&]() { 
+            right_hull = triangulate(right_edges, middle, end, threads - threads/2); 
+        });
+
+        auto [ldo, ldi] = triangulate(edges, begin, middle, threads/2);
+        right_thread.join();
+
+        // right edges are appended after the left ones, as they would be
+        // created by the sequential algorithm, so the result doesn't depend on threads
+        int offset = edges.size();
+        edges.append(right_edges);
+        return merge(edges, ldo, ldi, right_hull.first + offset, right_hull.second + offset);
+    }
+
+    auto [ldo, ldi] = triangulate(edges, begin, middle, 1);
+    auto [rdi, rdo] = triangulate(edges, middle, end, 1);
+    return merge(edges, ldo, ldi, rdi, rdo);
+}
+
+std::pair<int,int> divide_and_conquer::merge(quad_edges& edges, int ldo, int ldi, int rdi, int rdo) const
+{
+    // find the lower common tangent of the halves
+    while (true) {
+        if (left_of(edges, edges.origin(rdi), ldi)) {
+            ldi = edges.lnext(ldi);
+        }
+        else if (right_of(edges, edges.origin(ldi), rdi)) {
+            rdi = edges.rprev(rdi);
+        }
+        else {
+            break;
+        }
+    }
+
+    // base edge goes from the right half to the left half
+    int basel = edges.connect(edges.sym(rdi), ldi);
+    if (edges.origin(ldi) == edges.origin(ldo)) {
+        ldo = edges.sym(basel);
+    }
+    if (edges.origin(rdi) == edges.origin(rdo)) {
+        rdo = basel;
+    }
+
+    // candidate is valid if it is above the base edge
+    auto valid = [&](int e) { return right_of(edges, edges.destination(e), basel); };
+
+    // merge the halves from the bottom to the top
+    while (true) {
+        // left candidate, delete left edges that fail the circle test
+        int lcand = edges.onext(edges.sym(basel));
+        if (valid(lcand)) {
+            while (in_circle(edges.destination(basel), edges.origin(basel), edges.destination(lcand), edges.destination(edges.onext(lcand)))) {
+                int t = edges.onext(lcand);
+                edges.delete_edge(lcand);
+                lcand = t;
+            }
+        }
+
+        // right candidate, delete right edges that fail the circle test
+        int rcand = edges.oprev(basel);
+        if (valid(rcand)) {
+            while (in_circle(edges.destination(basel), edges.origin(basel), edges.destination(rcand), edges.destination(edges.oprev(rcand)))) {
+                int t = edges.oprev(rcand);
+                edges.delete_edge(rcand);
+                rcand = t;
+            }
+        }
+
+        if (!valid(lcand) && !valid(rcand)) {
+            // base edge is the upper common tangent
+            break;
+        }
+
+        // connect to the candidate whose circle is empty
+        if (!valid(lcand) || (valid(rcand) && in_circle(edges.destination(lcand), edges.origin(lcand), edges.origin(rcand), edges.destination(rcand)))) {
+            basel = edges.connect(rcand, edges.sym(basel));
+        }
+        else {
+            basel = edges.connect(edges.sym(basel), edges.sym(lcand));
+        }
+    }
+
+    return {ldo, rdo};
+}
+
+std::vector<std::array<int,3>> divide_and_conquer::triangles() const
+{
+    std::vector<bool> visited(m_edges.size(), false);
+
+    // skip the external face
+    int e = m_edges.sym(m_hull_edge);
+    do {
+        visited[e] = true;
+        e = m_edges.lnext(e);
+    } while (e != m_edges.sym(m_hull_edge));
+
+    std::vector<std::array<int,3>> result;
+    for (int i = 0; i < m_edges.size(); ++i) {
+        if (m_edges.deleted(i) || visited[i]) {
+            continue;
+        }
+
+        // every internal face is a triangle
+        int e2 = m_edges.lnext(i);
+        int e3 = m_edges.lnext(e2);
+        assert(m_edges.lnext(e3) == i);
+        visited[i] = visited[e2] = visited[e3] = true;
+        result.push_back({m_edges.origin(i), m_edges.origin(e2), m_edges.origin(e3)});
+    }
+
+    return result;
+}
+
+std::vector<std::pair<int,int>> divide_and_conquer::hull() const
+{
+    std::vector<std::pair<int,int>> result;
+
+    int e = m_edges.sym(m_hull_edge);
+    do {
+        result.emplace_back(m_edges.origin(e), m_edges.destination(e));
+        e = m_edges.lnext(e);
+    } while (e != m_edges.sym(m_hull_edge));
+
+    return result;
+}
+
+bool divide_and_conquer::ccw(int a, int b, int c) const
+{
+    if (m_integral) {
+        return util::orient2d_integer(m_points[a], m_points[b], m_points[c]) > 0;
+    }
+    return m_points[a].get_direction(m_points[b], m_points[c]) == util::direction::positive;
+}
+
+bool divide_and_conquer::right_of(const quad_edges& edges, int point_index, int e) const
+{
+    return ccw(point_index, edges.destination(e), edges.origin(e));
+}
+
+bool divide_and_conquer::left_of(const quad_edges& edges, int point_index, int e) const
+{
+    return ccw(point_index, edges.origin(e), edges.destination(e));
+}
+
+bool divide_and_conquer::in_circle(int a, int b, int c, int d) const
+{
+    if (m_integral) {
+        return util::in_circle_integer(m_points[a], m_points[b], m_points[c], m_points[d]) > 0;
+    }
+    return m_points[d].in_circle(m_points[a], m_points[b], m_points[c]);
+}
+
+// quad_edges
+int divide_and_conquer::quad_edges::make_edge(int origin, int destination)
+{
+    int e = m_edges.size();
+    m_edges.push_back({origin, e, e, false});
+    m_edges.push_back({destination, e+1, e+1, false});
+    return e;
+}
+
+int divide_and_conquer::quad_edges::connect(int a, int b)
+{
+    int e = make_edge(destination(a), origin(b));
+    splice(e, lnext(a));
+    splice(sym(e), b);
+    return e;
+}
+
+void divide_and_conquer::quad_edges::delete_edge(int e)
+{
+    splice(e, oprev(e));
+    splice(sym(e), oprev(sym(e)));
+    m_edges[e].deleted = true;
+    m_edges[sym(e)].deleted = true;
+}
+
+void divide_and_conquer::quad_edges::append(const quad_edges& other)
+{
+    int offset = m_edges.size();
+    std::transform(other.m_edges.cbegin(), other.m_edges.cend(), std::back_inserter(m_edges), [offset](half_edge e) {
+        return half_edge{e.origin, e.onext + offset, e.oprev + offset, e.deleted};
+    });
+}
+
+void divide_and_conquer::quad_edges::splice(int a, int b)
+{
+    int a_next = m_edges[a].onext;
+    int b_next = m_edges[b].onext;
+
+    m_edges[a].onext = b_next;
+    m_edges[b].onext = a_next;
+    m_edges[b_next].oprev = a;
+    m_edges[a_next].oprev = b;
+}
+
+int divide_and_conquer::quad_edges::sym(int e) const
+{
+    return e ^ 1;
+}
+
+int divide_and_conquer::quad_edges::onext(int e) const
+{
+    return m_edges[e].onext;
+}
+
+int divide_and_conquer::quad_edges::oprev(int e) const
+{
+    return m_edges[e].oprev;
+}
+
+int divide_and_conquer::quad_edges::lnext(int e) const
+{
+    return oprev(sym(e));
+}
+
+int divide_and_conquer::quad_edges::rprev(int e) const
+{
+    return onext(sym(e));
+}
+
+int divide_and_conquer::quad_edges::origin(int e) const
+{
+    return m_edges[e].origin;
+}
+
+int divide_and_conquer::quad_edges::destination(int e) const
+{
+    return m_edges[sym(e)].origin;
+}
+
+bool divide_and_conquer::quad_edges::deleted(int e) const
+{
+    return m_edges[e].deleted;
+}
+
+int divide_and_conquer::quad_edges::size() const
+{
+    return m_edges.size();
+}
+
+void divide_and_conquer::quad_edges::reserve(int size)
+{
+    m_edges.reserve(size);
+}
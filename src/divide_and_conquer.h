@@ -0,0 +1,94 @@
+#ifndef DIVIDE_AND_CONQUER_H
+#define DIVIDE_AND_CONQUER_H
+
+#include <vector>
+#include <array>
+#include <utility>
+
+#include "utility.h"
+
+class divide_and_conquer {
+    // guibas-stolfi divide and conquer delaunay triangulation algorithm
+public:
+    // if threads > 1, points are split into vertical strips that are triangulated
+    // on their own threads, and the strips are merged along the seams
+    // the result is the same for any number of threads
+    divide_and_conquer(const std::vector<util::point>& points, int threads = 1);
+
+    // returns triangles of the triangulation as indices of points in positive direction
+    std::vector<std::array<int,3>> triangles() const;
+
+    // returns boundary of the triangulation as edges (origin index, destination index)
+    // convex hull is to the right of every edge, so edges go around it in negative direction
+    // if all points are collinear, every edge is returned in both directions
+    std::vector<std::pair<int,int>> hull() const;
+
+private:
+    // half edge of the quad edge structure, twin of edge i is edge i^1
+    // edges with the same origin are in a circular list sorted in positive direction
+    struct half_edge {
+        int origin;
+        // next edge with the same origin in positive direction
+        int onext;
+        // next edge with the same origin in negative direction
+        int oprev;
+        bool deleted;
+    };
+
+    // edges of a part of the triangulation
+    class quad_edges {
+    public:
+        // returns new edge (and its twin) that is not connected to the other edges
+        int make_edge(int origin, int destination);
+        // returns new edge from destination of a to origin of b,
+        // so a, the new edge and b are in the same face
+        int connect(int a, int b);
+        void delete_edge(int e);
+        // exchanges origin rings of a and b
+        void splice(int a, int b);
+        // appends edges of other, ids of other's edges are shifted by the current size
+        void append(const quad_edges& other);
+
+        int sym(int e) const;
+        int onext(int e) const;
+        int oprev(int e) const;
+        // next edge in the left face
+        int lnext(int e) const;
+        // previous edge in the right face
+        int rprev(int e) const;
+        int origin(int e) const;
+        int destination(int e) const;
+        bool deleted(int e) const;
+
+        int size() const;
+        void reserve(int size);
+
+    private:
+        std::vector<half_edge> m_edges;
+    };
+
+    // triangulates points sorted_ids[begin, end) into edges
+    // threads - number of threads that can be used
+    // returns (ccw convex hull edge out of the leftmost point, cw convex hull edge out of the rightmost point)
+    std::pair<int,int> triangulate(quad_edges& edges, int begin, int end, int threads) const;
+    // merges two triangulations separated by a vertical line,
+    // parameters are hull edges returned by triangulate for the left and the right one
+    std::pair<int,int> merge(quad_edges& edges, int ldo, int ldi, int rdi, int rdo) const;
+
+    bool ccw(int a, int b, int c) const;
+    bool right_of(const quad_edges& edges, int point_index, int e) const;
+    bool left_of(const quad_edges& edges, int point_index, int e) const;
+    // returns true if point d is strictly inside the circle (a,b,c)
+    bool in_circle(int a, int b, int c, int d) const;
+
+    const std::vector<util::point>& m_points;
+    // true if all points are integral, predicates are then evaluated in integers
+    bool m_integral;
+    // points indices sorted by x coordinate, then by y coordinate
+    std::vector<int> m_sorted_ids;
+    quad_edges m_edges;
+    // ccw convex hull edge out of the leftmost point
+    int m_hull_edge = -1;
+};
+
+#endif /* DIVIDE_AND_CONQUER_H */
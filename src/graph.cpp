@@ -4,19 +4,21 @@
 #include <iostream>
 
 // node
-node::node(std::vector<int> vertices, int face_id)
-    : m_vertices(std::move(vertices))
+node::node(std::array<int,3> vertices, int face_id)
+    : m_vertices(vertices)
     , m_face(face_id)
 {}
 
-void node::set_children(std::vector<int> children)
+void node::set_children(std::initializer_list<int> children)
 {
-    m_children = std::move(children);
+    assert(children.size() <= m_children.size());
+    std::copy(children.begin(), children.end(), m_children.begin());
+    m_children_count = children.size();
 }
 
 int node::children_count() const
 {
-    return m_children.size();
+    return m_children_count;
 }
 
 int node::face() const
@@ -29,12 +31,12 @@ bool node::leaf() const
     return children_count() == 0;
 }
 
-const std::vector<int>& node::children() const
+int node::child(int i) const
 {
-    return m_children;
+    return m_children[i];
 }
 
-const std::vector<int>& node::vertices() const
+const std::array<int,3>& node::vertices() const
 {
     return m_vertices;
 }
@@ -60,18 +62,25 @@ const std::vector<node>& graph::nodes() const
     return m_nodes;
 }
 
+void graph::reserve(int size)
+{
+    m_nodes.reserve(size);
+}
+
 void graph::add(node n)
 {
     if (n.face() > 0)
     {
+        if (n.face() >= (int)m_face_to_node.size()) {
+            m_face_to_node.resize(std::max<int>(n.face()+1, 2*m_face_to_node.size()), -1);
+        }
         m_face_to_node[n.face()] = m_nodes.size();
     }
-    m_nodes.emplace_back(std::move(n));
+    m_nodes.push_back(n);
 }
 
 int graph::get_node(int face_id) const
 {
-    auto it = m_face_to_node.find(face_id); 
-    assert(it != m_face_to_node.end());
-    return it->second;
+    assert(face_id > 0 && face_id < (int)m_face_to_node.size() && m_face_to_node[face_id] != -1);
+    return m_face_to_node[face_id];
 }
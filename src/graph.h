@@ -2,25 +2,31 @@
 #define GRAPH_H 
 
 #include <vector>
-#include <unordered_map>
+#include <array>
+#include <initializer_list>
 
 class node {
+    // fixed size record, so the nodes are stored contiguously in the graph
+    // without allocations of their own
 public:
-    node(std::vector<int> vertices, int face_id);
+    node(std::array<int,3> vertices, int face_id);
 
-    const std::vector<int>& children() const;
-    const std::vector<int>& vertices() const;
+    // i-th child node id, i < children_count()
+    int child(int i) const;
+    const std::array<int,3>& vertices() const;
     int face() const;
 
-    void set_children(std::vector<int> children);
+    // node has 2 (flip) or 3 (split) children
+    void set_children(std::initializer_list<int> children);
     int children_count() const;
     bool leaf() const;
 
 private:
     // vertices ids
-    std::vector<int> m_vertices;
-    // children nodes ids
-    std::vector<int> m_children;
+    std::array<int,3> m_vertices;
+    // children nodes ids, first m_children_count are valid
+    std::array<int,3> m_children{};
+    int m_children_count = 0;
     // face id
     int m_face;
 };
@@ -37,11 +43,13 @@ public:
 
     void add(node n);
     int size() const;
+    // reserves space for the nodes, so they are not moved while the graph grows
+    void reserve(int size);
 
 private:
-    // map: face id -> node id
-    // last node id with face id
-    std::unordered_map<int,int> m_face_to_node;
+    // face id -> last node id with face id, -1 if there is no such node
+    // face ids are dense, so the vector grows with the face table
+    std::vector<int> m_face_to_node;
     std::vector<node> m_nodes;
 };
 
@@ -2,11 +2,11 @@
 #include <unordered_map>
 #include <algorithm>
 #include <cassert>
+#include <functional>
 
 largest_empty_circle::largest_empty_circle(const dcel& delaunay, const dcel& voronoi)
+    : m_convex_hull(delaunay)
 {
-    convex_hull ch(delaunay);
-
     std::unordered_map<int, bool> inside_map;
 
     auto check_point = [&](int point_id, const util::point& point) {
@@ -16,47 +16,195 @@ largest_empty_circle::largest_empty_circle(const dcel& delaunay, const dcel& vor
             return inside_map[point_id];
         }
         else {
-            if ((inside_map[point_id] = ch.inside(point))) {
-                // voronoi vertex id corresponds to delaunay face id
-                auto point_in_face = delaunay.point(point_id);
-                m_candidates.emplace_back(point, point.distance(point_in_face));
+            if ((inside_map[point_id] = m_convex_hull.inside(point))) {
+                add_vertex_candidate(delaunay, point_id, point);
             }
 
             return inside_map[point_id];
         }
     };
 
-    for (int i = 0; i < voronoi.edge_count(); i += 2) {
+    // skip removed and twin edges
+    for (int i = 0; i < voronoi.edge_count(); ++i) {
         auto voronoi_edge = voronoi.edge(i);
+        if (voronoi.edge_removed(i) || voronoi_edge.twin() < voronoi_edge.id()) {
+            continue;
+        }
         auto origin = voronoi_edge.point();
         int origin_id = voronoi_edge.origin();
         auto destination = (voronoi_edge | edgerelation::twin).point();
         int destination_id = (voronoi_edge | edgerelation::twin).origin();
 
-        if (!check_point(origin_id, origin) || !check_point(destination_id, destination)) {
+        // both points are checked, so a vertex is not missed when all its edges start outside
+        bool origin_inside = check_point(origin_id, origin);
+        bool destination_inside = check_point(destination_id, destination);
+        if (!origin_inside || !destination_inside) {
             // check intersection only if at least one point is outside the convex hull
             // it is important to node that intersection can exist even if both points are
             // outside of the convex hull
-            auto intersections = ch.get_inersection(origin, destination);
-            if (!intersections.empty()) {
-                auto vertices_ids_origin_face = delaunay.points_ids(origin_id);
-                auto vertices_ids_destination_face = delaunay.points_ids(destination_id);
-                assert(vertices_ids_origin_face.size() == 3);
-                assert(vertices_ids_destination_face.size() == 3);
-
-                // find a vertex id that belongs to both faces
-                auto it = std::find_if(vertices_ids_origin_face.begin(), vertices_ids_origin_face.end(), [&](int id) { 
-                              return std::any_of(vertices_ids_destination_face.begin(), vertices_ids_destination_face.end(),
-                                      [&](int id2) { return id == id2; });
-                          });
-
-                assert(it != vertices_ids_origin_face.end());
-                auto p = delaunay.vertex(*it-1).point();
-                std::transform(intersections.cbegin(), intersections.cend(), std::back_inserter(m_candidates), 
-                    [&](const auto& intersection_point) {
-                        return util::circle(intersection_point, intersection_point.distance(p));
-                    });
-            }
+            add_intersection_candidates(delaunay, voronoi, i);
+        }
+    }
+}
+
+largest_empty_circle::largest_empty_circle(const dcel& delaunay, const dcel& voronoi, const clipped_voronoi& clipped)
+    : m_convex_hull(delaunay)
+    , m_box(clipped.box())
+{
+    // voronoi vertices inside the boundary are kept in the clipped graph,
+    // clip points are intersections of voronoi edges and the boundary,
+    // corners of the convex hull are delaunay vertices, so they are not candidates,
+    // but corners of a box are
+    const auto& graph = clipped.graph();
+    for (int vertex_id = 1; vertex_id <= graph.vertex_count(); ++vertex_id) {
+        if (graph.vertex_removed(vertex_id-1)) {
+            continue;
+        }
+        auto point = graph.vertex(vertex_id-1).point();
+        int edge_id = clipped.crossed_edge(vertex_id);
+        if (clipped.boundary_edge(vertex_id) == -1) {
+            add_vertex_candidate(delaunay, vertex_id, point);
+        }
+        else if (edge_id != -1) {
+            // voronoi edge is in the face of the delaunay vertex nearest to the clip point
+            auto voronoi_edge = voronoi.edge(edge_id-1);
+            auto p = delaunay.vertex(voronoi_edge.face()-1).point();
+            m_intersection_candidates.push_back(m_candidates.size());
+            m_candidates.emplace_back(point, point.squared_distance(p), util::radius_type::squared_radius);
+            m_sources.emplace_back(voronoi_edge.origin(), (voronoi_edge | edgerelation::twin).origin());
+        }
+        else if (m_box) {
+            // corner is in the cell of the nearest delaunay vertex
+            auto p = delaunay.vertex(clipped.boundary_cell(vertex_id)-1).point();
+            m_candidates.emplace_back(point, point.squared_distance(p), util::radius_type::squared_radius);
+            m_sources.emplace_back(-1, -1);
+        }
+    }
+}
+
+void largest_empty_circle::update(const dcel& delaunay, const dcel& voronoi, const voronoitype::changes& changes)
+{
+    assert(!m_box);
+    if (changes.hull_changed) {
+        *this = largest_empty_circle(delaunay, voronoi);
+        return;
+    }
+
+    auto changed = [&](int vertex_id) {
+        return std::binary_search(changes.vertices.cbegin(), changes.vertices.cend(), vertex_id);
+    };
+
+    // indices of candidates of the changed voronoi vertices
+    std::vector<int> removed;
+    m_vertex_candidates.resize(voronoi.vertex_count()+1, -1);
+    for (int vertex_id : changes.vertices) {
+        if (m_vertex_candidates[vertex_id] != -1) {
+            removed.push_back(m_vertex_candidates[vertex_id]);
+        }
+    }
+    std::copy_if(m_intersection_candidates.cbegin(), m_intersection_candidates.cend(), std::back_inserter(removed), 
+            [&](int index) { return changed(m_sources[index].first) || changed(m_sources[index].second); });
+
+    // the last candidate is moved to the removed one, so remove them from the end
+    std::sort(removed.begin(), removed.end(), std::greater<int>());
+    for (int index : removed) {
+        remove_candidate(index);
+    }
+
+    for (int vertex_id : changes.vertices) {
+        auto point = voronoi.vertex(vertex_id-1).point();
+        if (m_convex_hull.inside(point)) {
+            add_vertex_candidate(delaunay, vertex_id, point);
+        }
+    }
+
+    // every edge with a changed vertex is rebuilt
+    for (int edge_id : changes.edges) {
+        auto voronoi_edge = voronoi.edge(edge_id-1);
+        auto twin = voronoi_edge | edgerelation::twin;
+        if (!changed(voronoi_edge.origin()) && !changed(twin.origin())) {
+            continue;
+        }
+
+        if (!m_convex_hull.inside(voronoi_edge.point()) || !m_convex_hull.inside(twin.point())) {
+            add_intersection_candidates(delaunay, voronoi, edge_id-1);
+        }
+    }
+}
+
+void largest_empty_circle::remove_candidate(int index)
+{
+    // intersection candidates are close to the convex hull, so there are few of them
+    auto intersection = [&](int i) { 
+        return std::find(m_intersection_candidates.begin(), m_intersection_candidates.end(), i);
+    };
+
+    if (m_sources[index].first == m_sources[index].second) {
+        m_vertex_candidates[m_sources[index].first] = -1;
+    }
+    else {
+        auto it = intersection(index);
+        *it = m_intersection_candidates.back();
+        m_intersection_candidates.pop_back();
+    }
+
+    // move the last candidate to the index
+    int last = m_candidates.size()-1;
+    if (index != last) {
+        m_candidates[index] = m_candidates[last];
+        m_sources[index] = m_sources[last];
+        if (m_sources[index].first == m_sources[index].second) {
+            m_vertex_candidates[m_sources[index].first] = index;
+        }
+        else {
+            *intersection(last) = index;
+        }
+    }
+
+    m_candidates.pop_back();
+    m_sources.pop_back();
+}
+
+void largest_empty_circle::add_vertex_candidate(const dcel& delaunay, int vertex_id, util::point point)
+{
+    // voronoi vertex id corresponds to delaunay face id
+    auto point_in_face = delaunay.point(vertex_id);
+    if (vertex_id >= (int)m_vertex_candidates.size()) {
+        m_vertex_candidates.resize(vertex_id+1, -1);
+    }
+    m_vertex_candidates[vertex_id] = m_candidates.size();
+    m_candidates.emplace_back(point, point.squared_distance(point_in_face), util::radius_type::squared_radius);
+    m_sources.emplace_back(vertex_id, vertex_id);
+}
+
+void largest_empty_circle::add_intersection_candidates(const dcel& delaunay, const dcel& voronoi, int edge_index)
+{
+    auto voronoi_edge = voronoi.edge(edge_index);
+    auto origin = voronoi_edge.point();
+    int origin_id = voronoi_edge.origin();
+    auto destination = (voronoi_edge | edgerelation::twin).point();
+    int destination_id = (voronoi_edge | edgerelation::twin).origin();
+
+    auto intersections = m_convex_hull.get_inersection(origin, destination);
+    if (!intersections.empty()) {
+        auto vertices_ids_origin_face = delaunay.triangle_ids(origin_id);
+        auto vertices_ids_destination_face = delaunay.triangle_ids(destination_id);
+
+        // find a vertex id that belongs to both faces
+        auto it = std::find_if(vertices_ids_origin_face.begin(), vertices_ids_origin_face.end(), [&](int id) { 
+                      return std::any_of(vertices_ids_destination_face.begin(), vertices_ids_destination_face.end(),
+                              [&](int id2) { return id == id2; });
+                  });
+
+        assert(it != vertices_ids_origin_face.end());
+        auto p = delaunay.vertex(*it-1).point();
+        std::transform(intersections.cbegin(), intersections.cend(), std::back_inserter(m_candidates), 
+            [&](const auto& intersection_point) {
+                return util::circle(intersection_point, intersection_point.squared_distance(p), util::radius_type::squared_radius);
+            });
+        for (int i = 0; i < (int)intersections.size(); ++i) {
+            m_intersection_candidates.push_back(m_candidates.size() - intersections.size() + i);
+            m_sources.emplace_back(origin_id, destination_id);
         }
     }
 }
@@ -68,7 +216,7 @@ const std::vector<util::circle>& largest_empty_circle::candidates() const
 
 util::circle largest_empty_circle::get_largest_circle() const
 {
-    // get a circle with maximum radius
+    // get a circle with maximum radius, squared radii have the same order
     return *std::max_element(m_candidates.begin(), m_candidates.end(), 
-            [](const auto& lhs, const auto& rhs) { return lhs.r() < rhs.r(); });
+            [](const auto& lhs, const auto& rhs) { return lhs.squared_r() < rhs.squared_r(); });
 }
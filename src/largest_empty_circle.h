@@ -4,18 +4,47 @@
 #include "utility.h"
 #include "dcel.h"
 #include "convex_hull.h"
+#include "voronoi.h"
+#include "clipped_voronoi.h"
 
 class largest_empty_circle {
 public:
     largest_empty_circle(const dcel& delaunay, const dcel& voronoi);
+    // candidates are the vertices of the clipped voronoi graph, so there are no intersection tests,
+    // centers are in the boundary the graph is clipped to, the convex hull or a box,
+    // clipped graph has to be built from the voronoi graph
+    largest_empty_circle(const dcel& delaunay, const dcel& voronoi, const clipped_voronoi& clipped);
+
+    // updates candidates after a point is added to the triangulation and the voronoi graph is updated,
+    // only candidates of the changed voronoi vertices and edges are computed again
+    // if the convex hull changed, all candidates are computed again
+    // centers are in the convex hull, so it cannot be used for circles in a box
+    void update(const dcel& delaunay, const dcel& voronoi, const voronoitype::changes& changes);
 
     const std::vector<util::circle>& candidates() const;
     util::circle get_largest_circle() const;
 
 private:
+    // removes candidate, the last candidate is moved to its index
+    void remove_candidate(int index);
+    // add candidate with the center in voronoi vertex
+    void add_vertex_candidate(const dcel& delaunay, int vertex_id, util::point point);
+    // add candidates with centers in intersections of voronoi edge and convex hull
+    void add_intersection_candidates(const dcel& delaunay, const dcel& voronoi, int edge_index);
+
+    convex_hull m_convex_hull;
     // candidate empty circles, 
     // the largest empty circle is in candidates
     std::vector<util::circle> m_candidates;
+    // ids of voronoi vertices the candidate is computed from,
+    // both ids are the same for a candidate in voronoi vertex
+    std::vector<std::pair<int,int>> m_sources;
+    // index of candidate in voronoi vertex with the given id, -1 if vertex is outside the convex hull
+    std::vector<int> m_vertex_candidates;
+    // indices of candidates in intersections of voronoi edges and convex hull
+    std::vector<int> m_intersection_candidates;
+    // true if the centers are in a box and not in the convex hull
+    bool m_box = false;
 };
 
 #endif /* LARGEST_EMPTY_CIRCLE_H */
@@ -0,0 +1,118 @@
+#include "lloyd.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "voronoi.h"
+
+// fewer centroids are computed on the current thread
+#define PARALLEL_MIN_CELLS (4096)
+
+lloyd::lloyd(const std::vector<util::point>& points, const std::vector<double>& box, lloydtype::options options)
+    : m_delaunay(points)
+{
+    while (m_iterations < options.max_iterations) {
+        const auto& triangulation = m_delaunay.triangulation();
+        voronoi vor{triangulation, options.threads};
+        auto moved_points = centroids(clipped_voronoi{triangulation, vor, box}, options.threads);
+
+        m_last_move = 0;
+        for (int i = 0; i < triangulation.vertex_count(); ++i) {
+            m_last_move = std::max(m_last_move, triangulation.vertex(i).point().distance(moved_points[i]));
+        }
+        ++m_iterations;
+
+        if (!m_delaunay.move(moved_points)) {
+            m_delaunay = delaunay{moved_points};
+            ++m_rebuilds;
+        }
+        if (m_last_move <= options.threshold) {
+            break;
+        }
+    }
+}
+
+std::vector<util::point> lloyd::centroids(const clipped_voronoi& clipped, int threads) const
+{
+    const auto& triangulation = m_delaunay.triangulation();
+    const auto& graph = clipped.graph();
+    int count = triangulation.vertex_count();
+    std::vector<util::point> result(count);
+
+    // centroid of the polygon is computed relative to the point of the cell,
+    // so the coordinates in the sums are small
+    //
+    //   A = 1/2 sum (x(i) y(i+1) - x(i+1) y(i))
+    //   C = 1/(6A) sum (p(i) + p(i+1)) (x(i) y(i+1) - x(i+1) y(i))
+    auto compute = [&](int part) {
+        int begin = (long long)count * part / threads;
+        int end = (long long)count * (part + 1) / threads;
+        for (int i = begin; i < end; ++i) {
+            auto site = triangulation.vertex(i).point();
+            result[i] = site;
+            if (triangulation.vertex_removed(i) || graph.face_removed(i+1)) {
+                continue;
+            }
+
+            double area = 0;
+            double x = 0;
+            double y = 0;
+            for (auto edge : graph.face_edges(i+1)) {
+                auto p = edge.point();
+                auto q = (edge | edgerelation::next).point();
+                double px = p.x() - site.x();
+                double py = p.y() - site.y();
+                double qx = q.x() - site.x();
+                double qy = q.y() - site.y();
+                double cross = px*qy - qx*py;
+                area += cross;
+                x += (px + qx) * cross;
+                y += (py + qy) * cross;
+            }
+            if (area > 0) {
+                result[i] = {site.x() + x / (3*area), site.y() + y / (3*area)};
+            }
+        }
+    };
+
+    threads = std::max(1, std::min(threads, count / PARALLEL_MIN_CELLS));
+    std::vector<std::thread> workers;
+    for (int part = 1; part < threads; ++part) {
+        workers.emplace_back(compute, part);
+    }
+    compute(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return result;
+}
+
+const delaunay& lloyd::triangulation() const
+{
+    return m_delaunay;
+}
+
+std::vector<util::point> lloyd::points() const
+{
+    std::vector<util::point> result;
+    for (const auto& v : m_delaunay.triangulation().vertices()) {
+        result.push_back(v.point());
+    }
+    return result;
+}
+
+int lloyd::iterations() const
+{
+    return m_iterations;
+}
+
+double lloyd::last_move() const
+{
+    return m_last_move;
+}
+
+int lloyd::rebuilds() const
+{
+    return m_rebuilds;
+}
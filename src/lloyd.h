@@ -0,0 +1,55 @@
+#ifndef LLOYD_H
+#define LLOYD_H
+
+#include <vector>
+
+#include "delaunay.h"
+#include "clipped_voronoi.h"
+#include "utility.h"
+
+namespace lloydtype {
+    struct options {
+        // iterations stop when no point moves farther than the threshold
+        double threshold = 1e-6;
+        // maximum number of iterations
+        int max_iterations = 100;
+        // number of threads used for the voronoi graph and the centroids,
+        // the points are the same for any number of threads
+        int threads = 1;
+    };
+}
+
+class lloyd {
+    // lloyd relaxation, every point is moved to the centroid of its voronoi cell clipped
+    // to the box until the points stop moving, so the voronoi cells get close to centroidal
+    //
+    // the triangulation is kept between iterations and repaired by delaunay::move, late
+    // iterations move the points very little, so only few edges are flipped, it is built
+    // again only if the highest point changes
+public:
+    // points should be in the box given as [min_x, max_x, min_y, max_y]
+    // throws std::invalid_argument if the box is not valid, see clipped_voronoi
+    lloyd(const std::vector<util::point>& points, const std::vector<double>& box, lloydtype::options options = {});
+
+    const delaunay& triangulation() const;
+    // relaxed points in the order of the vertices of the triangulation,
+    // the order can be different from the input one, see dcel::set_highest_first
+    std::vector<util::point> points() const;
+    int iterations() const;
+    // largest distance a point moved in the last iteration
+    double last_move() const;
+    // number of times the triangulation was built again
+    int rebuilds() const;
+
+private:
+    // returns centroids of the clipped cells in the order of the vertices,
+    // a vertex whose cell is outside the box is not moved
+    std::vector<util::point> centroids(const clipped_voronoi& clipped, int threads) const;
+
+    delaunay m_delaunay;
+    int m_iterations = 0;
+    double m_last_move = 0;
+    int m_rebuilds = 0;
+};
+
+#endif /* LLOYD_H */
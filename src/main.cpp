@@ -6,6 +6,7 @@
 #include <fstream>
 #include <cstdlib>
 #include <ctime>
+#include <thread>
 
 #include "utility.h"
 #include "dcel.h"
@@ -14,7 +15,7 @@
 #include "convex_hull.h"
 #include "largest_empty_circle.h"
 
-enum class option { delaunay, voronoi, circle, all_circles, convex_hull, unknown };
+enum class option { delaunay, voronoi, circle, all_circles, convex_hull, brio, walk, divide_and_conquer, parallel, unknown };
 
 option get_option(const std::string& option_string)
 {
@@ -23,6 +24,10 @@ option get_option(const std::string& option_string)
            (option_string == "circle") ? option::circle : 
            (option_string == "all_circles") ? option::all_circles : 
            (option_string == "convex_hull") ? option::convex_hull : 
+           (option_string == "brio") ? option::brio : 
+           (option_string == "walk") ? option::walk : 
+           (option_string == "divide_and_conquer") ? option::divide_and_conquer : 
+           (option_string == "parallel") ? option::parallel : 
            option::unknown;
 }
 
@@ -212,7 +217,7 @@ void init_window()
 int main(int argc, char** argv) 
 {
     if (argc < 2) {
-        std::cout << "usage: ./main input_file [delaunay] [voronoi] [convex_hull] [circle] [all_circles]" << std::endl;
+        std::cout << "usage: ./main input_file [delaunay] [voronoi] [convex_hull] [circle] [all_circles] [brio] [walk] [divide_and_conquer] [parallel]" << std::endl;
         return -1;
     }
 
@@ -237,7 +242,22 @@ int main(int argc, char** argv)
         enabled_options.emplace(get_option(argv[i]));
     }
 
-    delaunay del{points};
+    delaunaytype::options delaunay_options;
+    if (enabled_options.find(option::brio) != enabled_options.end()) {
+        delaunay_options.order = delaunaytype::insertion_order::brio;
+    }
+    if (enabled_options.find(option::walk) != enabled_options.end()) {
+        delaunay_options.location = delaunaytype::point_location::walk;
+    }
+    if (enabled_options.find(option::divide_and_conquer) != enabled_options.end()) {
+        delaunay_options.engine = delaunaytype::engine::divide_and_conquer;
+    }
+    if (enabled_options.find(option::parallel) != enabled_options.end()) {
+        delaunay_options.engine = delaunaytype::engine::divide_and_conquer;
+        delaunay_options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    delaunay del{points, delaunay_options};
 
     delaunay_edges = del.get_edges();
     auto range = del.range();
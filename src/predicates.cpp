@@ -0,0 +1,380 @@
+#include "predicates.h"
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BATCH_WIDTH (4)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BATCH_WIDTH (2)
+#else
+#define BATCH_WIDTH (1)
+#endif
+
+// the exact evaluation relies on every operation being rounded to the nearest double,
+// so the code must not be compiled with -ffast-math or with contraction into fma,
+// contraction is turned off by -ffp-contract=off in CMakeLists.txt
+
+namespace {
+    // 2^27 + 1, used to split a double into two halves of 26 bits
+    const double splitter = 134217729.0;
+    // maximum number of components of a product of two expansions used here
+    const int max_product_length = 512;
+
+    // floating point expansion is a sum of doubles (components) that don't overlap,
+    // sorted by magnitude from the smallest one, the last component has the sign of the sum
+
+    // a + b = x + y exactly, |a| >= |b|
+    void fast_two_sum(double a, double b, double& x, double& y)
+    {
+        x = a + b;
+        double b_virtual = x - a;
+        y = b - b_virtual;
+    }
+
+    // a + b = x + y exactly
+    void two_sum(double a, double b, double& x, double& y)
+    {
+        x = a + b;
+        double b_virtual = x - a;
+        double a_virtual = x - b_virtual;
+        y = (a - a_virtual) + (b - b_virtual);
+    }
+
+    // a - b = x + y exactly
+    void two_diff(double a, double b, double& x, double& y)
+    {
+        x = a - b;
+        double b_virtual = a - x;
+        double a_virtual = x + b_virtual;
+        y = (a - a_virtual) + (b_virtual - b);
+    }
+
+    // a = high + low, both halves have at most 26 significant bits
+    void split(double a, double& high, double& low)
+    {
+        double c = splitter * a;
+        double a_big = c - a;
+        high = c - a_big;
+        low = a - high;
+    }
+
+    // a * b = x + y exactly, b is already split into b_high and b_low
+    void two_product_presplit(double a, double b, double b_high, double b_low, double& x, double& y)
+    {
+        x = a * b;
+        double a_high, a_low;
+        split(a, a_high, a_low);
+        double error1 = x - (a_high * b_high);
+        double error2 = error1 - (a_low * b_high);
+        double error3 = error2 - (a_high * b_low);
+        y = (a_low * b_low) - error3;
+    }
+
+    // returns length of the expansion a - b
+    int difference(double a, double b, double* h)
+    {
+        double x, y;
+        two_diff(a, b, x, y);
+        if (y == 0.0) {
+            h[0] = x;
+            return 1;
+        }
+        h[0] = y;
+        h[1] = x;
+        return 2;
+    }
+
+    // h = e + f, returns length of h, zero components are removed
+    int sum(int e_length, const double* e, int f_length, const double* f, double* h)
+    {
+        int e_index = 0;
+        int f_index = 0;
+        int h_index = 0;
+        double e_now = e[0];
+        double f_now = f[0];
+        double q, q_new, h_h;
+
+        // takes the component with the smaller magnitude
+        auto e_smaller = [&]() { return (f_now > e_now) == (f_now > -e_now); };
+
+        if (e_smaller()) {
+            q = e_now;
+            if (++e_index < e_length) e_now = e[e_index];
+        }
+        else {
+            q = f_now;
+            if (++f_index < f_length) f_now = f[f_index];
+        }
+
+        if (e_index < e_length && f_index < f_length) {
+            if (e_smaller()) {
+                fast_two_sum(e_now, q, q_new, h_h);
+                if (++e_index < e_length) e_now = e[e_index];
+            }
+            else {
+                fast_two_sum(f_now, q, q_new, h_h);
+                if (++f_index < f_length) f_now = f[f_index];
+            }
+            q = q_new;
+            if (h_h != 0.0) {
+                h[h_index++] = h_h;
+            }
+
+            while (e_index < e_length && f_index < f_length) {
+                if (e_smaller()) {
+                    two_sum(q, e_now, q_new, h_h);
+                    if (++e_index < e_length) e_now = e[e_index];
+                }
+                else {
+                    two_sum(q, f_now, q_new, h_h);
+                    if (++f_index < f_length) f_now = f[f_index];
+                }
+                q = q_new;
+                if (h_h != 0.0) {
+                    h[h_index++] = h_h;
+                }
+            }
+        }
+
+        while (e_index < e_length) {
+            two_sum(q, e_now, q_new, h_h);
+            if (++e_index < e_length) e_now = e[e_index];
+            q = q_new;
+            if (h_h != 0.0) {
+                h[h_index++] = h_h;
+            }
+        }
+        while (f_index < f_length) {
+            two_sum(q, f_now, q_new, h_h);
+            if (++f_index < f_length) f_now = f[f_index];
+            q = q_new;
+            if (h_h != 0.0) {
+                h[h_index++] = h_h;
+            }
+        }
+
+        if (q != 0.0 || h_index == 0) {
+            h[h_index++] = q;
+        }
+        return h_index;
+    }
+
+    // h = e * b, returns length of h, zero components are removed
+    int scale(int e_length, const double* e, double b, double* h)
+    {
+        double b_high, b_low;
+        split(b, b_high, b_low);
+
+        double q, h_h;
+        two_product_presplit(e[0], b, b_high, b_low, q, h_h);
+        int h_index = 0;
+        if (h_h != 0.0) {
+            h[h_index++] = h_h;
+        }
+
+        for (int i = 1; i < e_length; ++i) {
+            double product1, product0, sum;
+            two_product_presplit(e[i], b, b_high, b_low, product1, product0);
+            two_sum(q, product0, sum, h_h);
+            if (h_h != 0.0) {
+                h[h_index++] = h_h;
+            }
+            fast_two_sum(product1, sum, q, h_h);
+            if (h_h != 0.0) {
+                h[h_index++] = h_h;
+            }
+        }
+
+        if (q != 0.0 || h_index == 0) {
+            h[h_index++] = q;
+        }
+        return h_index;
+    }
+
+    // h = e * f, returns length of h
+    int product(int e_length, const double* e, int f_length, const double* f, double* h)
+    {
+        double scaled[max_product_length];
+        double accumulated[max_product_length];
+
+        int h_length = scale(f_length, f, e[0], h);
+        for (int i = 1; i < e_length; ++i) {
+            int scaled_length = scale(f_length, f, e[i], scaled);
+            int accumulated_length = sum(h_length, h, scaled_length, scaled, accumulated);
+            std::copy(accumulated, accumulated + accumulated_length, h);
+            h_length = accumulated_length;
+        }
+        return h_length;
+    }
+
+    // e = -e
+    void negate(int e_length, double* e)
+    {
+        for (int i = 0; i < e_length; ++i) {
+            e[i] = -e[i];
+        }
+    }
+
+    // h = a1*b1 - a2*b2, returns length of h
+    int cross(int a1_length, const double* a1, int b1_length, const double* b1,
+              int a2_length, const double* a2, int b2_length, const double* b2, double* h)
+    {
+        double left[8];
+        double right[8];
+        int left_length = product(a1_length, a1, b1_length, b1, left);
+        int right_length = product(a2_length, a2, b2_length, b2, right);
+        negate(right_length, right);
+        return sum(left_length, left, right_length, right, h);
+    }
+}
+
+double util::orient2d_exact(point a, point b, point c)
+{
+    double acx[2], acy[2], bcx[2], bcy[2];
+    int acx_length = difference(a.x(), c.x(), acx);
+    int acy_length = difference(a.y(), c.y(), acy);
+    int bcx_length = difference(b.x(), c.x(), bcx);
+    int bcy_length = difference(b.y(), c.y(), bcy);
+
+    double determinant[16];
+    int length = cross(acx_length, acx, bcy_length, bcy, acy_length, acy, bcx_length, bcx, determinant);
+    return determinant[length-1];
+}
+
+double util::in_circle_exact(point a, point b, point c, point d)
+{
+    double adx[2], ady[2], bdx[2], bdy[2], cdx[2], cdy[2];
+    int adx_length = difference(a.x(), d.x(), adx);
+    int ady_length = difference(a.y(), d.y(), ady);
+    int bdx_length = difference(b.x(), d.x(), bdx);
+    int bdy_length = difference(b.y(), d.y(), bdy);
+    int cdx_length = difference(c.x(), d.x(), cdx);
+    int cdy_length = difference(c.y(), d.y(), cdy);
+
+    // (xdx)² + (xdy)² * (minor of the third column)
+    auto term = [](int x_length, const double* x, int y_length, const double* y, double* minor, int minor_length, double* h) {
+        double x_squared[8];
+        double y_squared[8];
+        double lift[16];
+        int x_squared_length = product(x_length, x, x_length, x, x_squared);
+        int y_squared_length = product(y_length, y, y_length, y, y_squared);
+        int lift_length = sum(x_squared_length, x_squared, y_squared_length, y_squared, lift);
+        return product(lift_length, lift, minor_length, minor, h);
+    };
+
+    double bc[16], ca[16], ab[16];
+    int bc_length = cross(bdx_length, bdx, cdy_length, cdy, cdx_length, cdx, bdy_length, bdy, bc);
+    int ca_length = cross(cdx_length, cdx, ady_length, ady, adx_length, adx, cdy_length, cdy, ca);
+    int ab_length = cross(adx_length, adx, bdy_length, bdy, bdx_length, bdx, ady_length, ady, ab);
+
+    double a_term[max_product_length], b_term[max_product_length], c_term[max_product_length];
+    int a_length = term(adx_length, adx, ady_length, ady, bc, bc_length, a_term);
+    int b_length = term(bdx_length, bdx, bdy_length, bdy, ca, ca_length, b_term);
+    int c_length = term(cdx_length, cdx, cdy_length, cdy, ab, ab_length, c_term);
+
+    double ab_terms[2*max_product_length];
+    double determinant[3*max_product_length];
+    int ab_terms_length = sum(a_length, a_term, b_length, b_term, ab_terms);
+    int length = sum(ab_terms_length, ab_terms, c_length, c_term, determinant);
+    return determinant[length-1];
+}
+
+unsigned util::negative_directions(point p, orientation_batch& batch)
+{
+    // lanes are processed in groups of BATCH_WIDTH
+    int count = batch.count;
+    while (batch.count % BATCH_WIDTH != 0) {
+        batch.add_positive();
+    }
+
+    // lanes with negative determinant, lanes whose determinant is below the error bound
+    // and lanes with point > source
+    unsigned negative = 0;
+    unsigned undecided = 0;
+    unsigned greater = 0;
+
+#if defined(__AVX__)
+    const __m256d px = _mm256_set1_pd(p.x());
+    const __m256d py = _mm256_set1_pd(p.y());
+    const __m256d error_bound = _mm256_set1_pd(predicates::orient2d_error_bound);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+
+    for (int i = 0; i < batch.count; i += 4) {
+        __m256d sx = _mm256_load_pd(batch.source_x + i);
+        __m256d sy = _mm256_load_pd(batch.source_y + i);
+        __m256d sxp = _mm256_sub_pd(sx, px);
+        __m256d syp = _mm256_sub_pd(sy, py);
+        __m256d dxp = _mm256_sub_pd(_mm256_load_pd(batch.destination_x + i), px);
+        __m256d dyp = _mm256_sub_pd(_mm256_load_pd(batch.destination_y + i), py);
+
+        // orient2d(source, destination, point) with the error bound
+        __m256d left = _mm256_mul_pd(sxp, dyp);
+        __m256d right = _mm256_mul_pd(syp, dxp);
+        __m256d determinant = _mm256_sub_pd(left, right);
+        __m256d error = _mm256_mul_pd(error_bound, _mm256_add_pd(_mm256_andnot_pd(sign, left), _mm256_andnot_pd(sign, right)));
+        negative |= (unsigned)_mm256_movemask_pd(_mm256_cmp_pd(determinant, _mm256_xor_pd(sign, error), _CMP_LT_OQ)) << i;
+        undecided |= (unsigned)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(sign, determinant), error, _CMP_LT_OQ)) << i;
+
+        // point > source, points are compared by y, then by x
+        __m256d above = _mm256_or_pd(_mm256_cmp_pd(py, sy, _CMP_GT_OQ),
+                _mm256_and_pd(_mm256_cmp_pd(py, sy, _CMP_EQ_OQ), _mm256_cmp_pd(px, sx, _CMP_GT_OQ)));
+        greater |= (unsigned)_mm256_movemask_pd(above) << i;
+    }
+#elif defined(__SSE2__)
+    const __m128d px = _mm_set1_pd(p.x());
+    const __m128d py = _mm_set1_pd(p.y());
+    const __m128d error_bound = _mm_set1_pd(predicates::orient2d_error_bound);
+    const __m128d sign = _mm_set1_pd(-0.0);
+
+    for (int i = 0; i < batch.count; i += 2) {
+        __m128d sx = _mm_load_pd(batch.source_x + i);
+        __m128d sy = _mm_load_pd(batch.source_y + i);
+        __m128d sxp = _mm_sub_pd(sx, px);
+        __m128d syp = _mm_sub_pd(sy, py);
+        __m128d dxp = _mm_sub_pd(_mm_load_pd(batch.destination_x + i), px);
+        __m128d dyp = _mm_sub_pd(_mm_load_pd(batch.destination_y + i), py);
+
+        // orient2d(source, destination, point) with the error bound
+        __m128d left = _mm_mul_pd(sxp, dyp);
+        __m128d right = _mm_mul_pd(syp, dxp);
+        __m128d determinant = _mm_sub_pd(left, right);
+        __m128d error = _mm_mul_pd(error_bound, _mm_add_pd(_mm_andnot_pd(sign, left), _mm_andnot_pd(sign, right)));
+        negative |= (unsigned)_mm_movemask_pd(_mm_cmplt_pd(determinant, _mm_xor_pd(sign, error))) << i;
+        undecided |= (unsigned)_mm_movemask_pd(_mm_cmplt_pd(_mm_andnot_pd(sign, determinant), error)) << i;
+
+        // point > source, points are compared by y, then by x
+        __m128d above = _mm_or_pd(_mm_cmpgt_pd(py, sy), _mm_and_pd(_mm_cmpeq_pd(py, sy), _mm_cmpgt_pd(px, sx)));
+        greater |= (unsigned)_mm_movemask_pd(above) << i;
+    }
+#else
+    for (int i = 0; i < batch.count; ++i) {
+        double left = (batch.source_x[i] - p.x()) * (batch.destination_y[i] - p.y());
+        double right = (batch.source_y[i] - p.y()) * (batch.destination_x[i] - p.x());
+        double determinant = left - right;
+        double error = predicates::orient2d_error_bound * (std::fabs(left) + std::fabs(right));
+        negative |= (unsigned)(determinant < -error) << i;
+        undecided |= (unsigned)(std::fabs(determinant) < error) << i;
+        greater |= (unsigned)(p.y() > batch.source_y[i] || (p.y() == batch.source_y[i] && p.x() > batch.source_x[i])) << i;
+    }
+#endif
+
+    // symbolic lanes are selected by the mask, their geometric result is ignored
+    negative = (negative & ~batch.symbolic) | ((greater ^ batch.invert) & batch.symbolic);
+    undecided &= ~batch.symbolic;
+
+    // padding lanes are never negative
+    negative &= (1u << count) - 1;
+    undecided &= (1u << count) - 1;
+
+    // sign of the determinant is not certain, evaluate it exactly
+    for (int i = 0; i < count; ++i) {
+        if (undecided & (1u << i)) {
+            point source{batch.source_x[i], batch.source_y[i]};
+            point destination{batch.destination_x[i], batch.destination_y[i]};
+            negative = (orient2d(source, destination, p) < 0.0) ? (negative | (1u << i)) : (negative & ~(1u << i));
+        }
+    }
+
+    return negative;
+}
@@ -0,0 +1,220 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "utility.h"
+
+namespace util {
+    // robust geometric predicates in the style of shewchuk's adaptive predicates:
+    // the determinant is evaluated in doubles and its sign is returned if it is
+    // bigger than the error bound of the evaluation, otherwise the determinant
+    // is evaluated exactly using floating point expansions
+    // the double evaluation is inline, because it is called in the innermost loops
+
+    // returns a value whose sign is the sign of the determinant
+    // | ax-cx  ay-cy |
+    // | bx-cx  by-cy |
+    // positive if a - b - c is in positive direction, 0 if they are collinear
+    double orient2d(point a, point b, point c);
+
+    // returns a value whose sign is the sign of the determinant
+    // | ax-dx  ay-dy  (ax-dx)²+(ay-dy)² |
+    // | bx-dx  by-dy  (bx-dx)²+(by-dy)² |
+    // | cx-dx  cy-dy  (cx-dx)²+(cy-dy)² |
+    // if a - b - c is in positive direction, it is positive if d is inside
+    // the circle (a,b,c), 0 if d is on the circle and negative if d is outside
+    double in_circle(point a, point b, point c, point d);
+
+    // exact values of the determinants, used when the error bound is exceeded
+    double orient2d_exact(point a, point b, point c);
+    double in_circle_exact(point a, point b, point c, point d);
+
+    // returns true if coordinates of the point are integers whose absolute value
+    // is at most predicates::max_integer
+    bool integral(point p);
+
+    // the same determinants for integral points, see integral, they are evaluated
+    // in 64-bit and 128-bit integers without rounding, so there is no filter
+    std::int64_t orient2d_integer(point a, point b, point c);
+    // returns -1, 0 or 1
+    int in_circle_integer(point a, point b, point c, point d);
+
+    // orientation tests of one point against several directed edges that are evaluated
+    // together with simd instructions, lanes are filled by the caller
+    // lane i answers whether source(i) - destination(i) - point is in negative direction
+    struct orientation_batch {
+        static constexpr int size = 12;
+
+        alignas(32) double source_x[size];
+        alignas(32) double source_y[size];
+        alignas(32) double destination_x[size];
+        alignas(32) double destination_y[size];
+        // bit i is set if lane i is symbolic, symbolic lane stores its reference point
+        // as both source and destination, and it is negative iff (point > reference) xor invert
+        unsigned symbolic = 0;
+        // bit i is set if symbolic lane i is inverted
+        unsigned invert = 0;
+        int count = 0;
+
+        // adds lane that tests source - destination - point
+        void add(point source, point destination);
+        // adds lane that is negative iff (point > reference) xor invert
+        void add_symbolic(point reference, bool invert);
+        // adds lane that is never negative
+        void add_positive();
+    };
+
+    // returns bitmask of lanes of the batch whose direction is negative,
+    // lanes that cannot be decided in doubles are evaluated exactly,
+    // the batch is padded to the simd width
+    unsigned negative_directions(point p, orientation_batch& batch);
+
+    namespace predicates {
+        constexpr double epsilon = std::numeric_limits<double>::epsilon() / 2;
+        // error bounds of the double evaluation relative to the permanent of the determinant
+        constexpr double orient2d_error_bound = (3.0 + 16.0 * epsilon) * epsilon;
+        constexpr double in_circle_error_bound = (10.0 + 96.0 * epsilon) * epsilon;
+        // differences of integral coordinates have at most 30 bits, so the lifted
+        // coordinates and the 2x2 minors fit in 62 bits and in_circle fits in 125 bits
+        constexpr double max_integer = 536870912.0;
+    }
+}
+
+inline void util::orientation_batch::add(point source, point destination)
+{
+    source_x[count] = source.x();
+    source_y[count] = source.y();
+    destination_x[count] = destination.x();
+    destination_y[count] = destination.y();
+    // the lane can be written again, if the caller dropped it
+    symbolic &= ~(1u << count);
+    invert &= ~(1u << count);
+    ++count;
+}
+
+inline void util::orientation_batch::add_symbolic(point reference, bool invert_direction)
+{
+    // the edge is degenerate, so the geometric test is not negative
+    add(reference, reference);
+    symbolic |= 1u << (count - 1);
+    invert |= (unsigned)invert_direction << (count - 1);
+}
+
+inline void util::orientation_batch::add_positive()
+{
+    // no point is above the reference at infinity
+    add_symbolic({0.0, std::numeric_limits<double>::infinity()}, false);
+}
+
+inline double util::orient2d(point a, point b, point c)
+{
+    double left = (a.x() - c.x()) * (b.y() - c.y());
+    double right = (a.y() - c.y()) * (b.x() - c.x());
+    double determinant = left - right;
+
+    // if the products have different signs, there is no cancellation
+    // and the sign of the rounded determinant is correct
+    double permanent;
+    if (left > 0.0) {
+        if (right <= 0.0) {
+            return determinant;
+        }
+        permanent = left + right;
+    }
+    else if (left < 0.0) {
+        if (right >= 0.0) {
+            return determinant;
+        }
+        permanent = -left - right;
+    }
+    else {
+        return determinant;
+    }
+
+    double error_bound = predicates::orient2d_error_bound * permanent;
+    if (determinant >= error_bound || -determinant >= error_bound) {
+        return determinant;
+    }
+
+    return orient2d_exact(a, b, c);
+}
+
+inline double util::in_circle(point a, point b, point c, point d)
+{
+    double adx = a.x() - d.x();
+    double ady = a.y() - d.y();
+    double bdx = b.x() - d.x();
+    double bdy = b.y() - d.y();
+    double cdx = c.x() - d.x();
+    double cdy = c.y() - d.y();
+
+    double bdx_cdy = bdx * cdy;
+    double cdx_bdy = cdx * bdy;
+    double a_lift = adx * adx + ady * ady;
+
+    double cdx_ady = cdx * ady;
+    double adx_cdy = adx * cdy;
+    double b_lift = bdx * bdx + bdy * bdy;
+
+    double adx_bdy = adx * bdy;
+    double bdx_ady = bdx * ady;
+    double c_lift = cdx * cdx + cdy * cdy;
+
+    double determinant = a_lift * (bdx_cdy - cdx_bdy)
+                       + b_lift * (cdx_ady - adx_cdy)
+                       + c_lift * (adx_bdy - bdx_ady);
+
+    double permanent = (std::fabs(bdx_cdy) + std::fabs(cdx_bdy)) * a_lift
+                     + (std::fabs(cdx_ady) + std::fabs(adx_cdy)) * b_lift
+                     + (std::fabs(adx_bdy) + std::fabs(bdx_ady)) * c_lift;
+
+    double error_bound = predicates::in_circle_error_bound * permanent;
+    if (determinant > error_bound || -determinant > error_bound) {
+        return determinant;
+    }
+
+    return in_circle_exact(a, b, c, d);
+}
+
+inline bool util::integral(point p)
+{
+    return std::fabs(p.x()) <= predicates::max_integer && std::fabs(p.y()) <= predicates::max_integer &&
+           std::trunc(p.x()) == p.x() && std::trunc(p.y()) == p.y();
+}
+
+inline std::int64_t util::orient2d_integer(point a, point b, point c)
+{
+    std::int64_t acx = static_cast<std::int64_t>(a.x()) - static_cast<std::int64_t>(c.x());
+    std::int64_t acy = static_cast<std::int64_t>(a.y()) - static_cast<std::int64_t>(c.y());
+    std::int64_t bcx = static_cast<std::int64_t>(b.x()) - static_cast<std::int64_t>(c.x());
+    std::int64_t bcy = static_cast<std::int64_t>(b.y()) - static_cast<std::int64_t>(c.y());
+
+    return acx * bcy - acy * bcx;
+}
+
+inline int util::in_circle_integer(point a, point b, point c, point d)
+{
+    std::int64_t dx = static_cast<std::int64_t>(d.x());
+    std::int64_t dy = static_cast<std::int64_t>(d.y());
+    std::int64_t adx = static_cast<std::int64_t>(a.x()) - dx;
+    std::int64_t ady = static_cast<std::int64_t>(a.y()) - dy;
+    std::int64_t bdx = static_cast<std::int64_t>(b.x()) - dx;
+    std::int64_t bdy = static_cast<std::int64_t>(b.y()) - dy;
+    std::int64_t cdx = static_cast<std::int64_t>(c.x()) - dx;
+    std::int64_t cdy = static_cast<std::int64_t>(c.y()) - dy;
+
+    std::int64_t a_lift = adx * adx + ady * ady;
+    std::int64_t b_lift = bdx * bdx + bdy * bdy;
+    std::int64_t c_lift = cdx * cdx + cdy * cdy;
+
+    __int128 determinant = static_cast<__int128>(a_lift) * (bdx * cdy - cdx * bdy)
+                         + static_cast<__int128>(b_lift) * (cdx * ady - adx * cdy)
+                         + static_cast<__int128>(c_lift) * (adx * bdy - bdx * ady);
+
+    return (determinant > 0) - (determinant < 0);
+}
+
+#endif /* PREDICATES_H */
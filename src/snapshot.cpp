@@ -0,0 +1,325 @@
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// arrays start at multiples of the cache line size
+#define ALIGNMENT (64)
+
+static_assert(sizeof(int) == sizeof(std::int32_t), "ids are stored as 32-bit integers");
+
+namespace {
+    const char magic[8] = {'D', 'C', 'E', 'L', 'S', 'N', 'A', 'P'};
+    const std::uint32_t byte_order = 0x01020304;
+
+    // writes arrays aligned to ALIGNMENT and returns their offsets
+    class writer {
+    public:
+        writer(std::ofstream& out)
+            : m_out(out)
+        {}
+
+        template <typename T>
+        std::uint64_t write(const T* data, std::size_t count)
+        {
+            static const char padding[ALIGNMENT] = {};
+            auto offset = (std::uint64_t)m_out.tellp();
+            auto aligned = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+            m_out.write(padding, aligned - offset);
+            m_out.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+            return aligned;
+        }
+
+        template <typename T>
+        std::uint64_t write(const std::vector<T>& data)
+        {
+            return write(data.data(), data.size());
+        }
+
+    private:
+        std::ofstream& m_out;
+    };
+}
+
+// dcel_view
+int snapshottype::dcel_view::vertex_count() const
+{
+    return m_section.vertex_count;
+}
+
+int snapshottype::dcel_view::edge_count() const
+{
+    return m_section.edge_count;
+}
+
+int snapshottype::dcel_view::face_count() const
+{
+    return m_section.face_count;
+}
+
+util::point snapshottype::dcel_view::point(int vertex_index) const
+{
+    return {array<util::coordinate>(m_section.x)[vertex_index], array<util::coordinate>(m_section.y)[vertex_index]};
+}
+
+int snapshottype::dcel_view::incident_edge(int vertex_index) const
+{
+    return array<int>(m_section.incident_edges)[vertex_index];
+}
+
+int snapshottype::dcel_view::origin(int edge_index) const
+{
+    return array<int>(m_section.edge_origins)[edge_index];
+}
+
+int snapshottype::dcel_view::twin(int edge_index) const
+{
+    return dceltype::twin(edge_index+1);
+}
+
+int snapshottype::dcel_view::previous(int edge_index) const
+{
+    return array<int>(m_section.edge_previous)[edge_index];
+}
+
+int snapshottype::dcel_view::next(int edge_index) const
+{
+    return array<int>(m_section.edge_next)[edge_index];
+}
+
+int snapshottype::dcel_view::face(int edge_index) const
+{
+    return array<int>(m_section.edge_faces)[edge_index];
+}
+
+bool snapshottype::dcel_view::edge_removed(int edge_index) const
+{
+    return origin(edge_index) == 0;
+}
+
+int snapshottype::dcel_view::face_edge(int face_id) const
+{
+    return array<int>(m_section.face_edges)[face_id];
+}
+
+bool snapshottype::dcel_view::imaginary(int face_id) const
+{
+    return array<std::uint8_t>(m_section.face_flags)[face_id] & dceltype::imaginary_face;
+}
+
+bool snapshottype::dcel_view::bottom(int face_id) const
+{
+    return array<std::uint8_t>(m_section.face_flags)[face_id] & dceltype::bottom_face;
+}
+
+bool snapshottype::dcel_view::hull_adjacent(int face_id) const
+{
+    return array<std::uint8_t>(m_section.face_flags)[face_id] & dceltype::hull_adjacent_face;
+}
+
+dcel snapshottype::dcel_view::to_dcel() const
+{
+    dcel result;
+
+    result.m_vertices.reserve(vertex_count());
+    for (int i = 0; i < vertex_count(); ++i) {
+        result.m_vertices.emplace_back(point(i), incident_edge(i));
+    }
+
+    auto copy = [&](std::uint64_t offset, int count, auto& destination) {
+        using T = typename std::remove_reference_t<decltype(destination)>::value_type;
+        destination.assign(array<T>(offset), array<T>(offset) + count);
+    };
+    copy(m_section.edge_origins, edge_count(), result.m_edge_origins);
+    copy(m_section.edge_previous, edge_count(), result.m_edge_previous);
+    copy(m_section.edge_next, edge_count(), result.m_edge_next);
+    copy(m_section.edge_faces, edge_count(), result.m_edge_faces);
+    copy(m_section.face_flags, face_count(), result.m_face_flags);
+    copy(m_section.free_edges, m_section.free_edge_count, result.m_free_edges);
+    copy(m_section.free_faces, m_section.free_face_count, result.m_free_faces);
+
+    result.m_faces.reserve(face_count());
+    for (int i = 0; i < face_count(); ++i) {
+        result.m_faces.emplace_back(face_edge(i));
+    }
+    result.m_integral = m_section.integral;
+
+    return result;
+}
+
+// snapshot
+void snapshot::write(const std::string& path, const dcel& triangulation, const dcel& voronoi)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open snapshot file " + path);
+    }
+
+    // header is written again when the offsets are known
+    snapshottype::header header{};
+    std::copy(std::begin(magic), std::end(magic), header.magic);
+    header.version = snapshottype::version;
+    header.coordinate_size = sizeof(util::coordinate);
+    header.byte_order = byte_order;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    writer w(out);
+    const dcel* dcels[2] = {&triangulation, &voronoi};
+    for (int i = 0; i < 2; ++i) {
+        const dcel& d = *dcels[i];
+        auto& section = header.sections[i];
+        section.vertex_count = d.vertex_count();
+        section.edge_count = d.edge_count();
+        section.face_count = d.face_count();
+        section.free_edge_count = d.m_free_edges.size();
+        section.free_face_count = d.m_free_faces.size();
+        section.integral = d.integral();
+
+        std::vector<util::coordinate> x, y;
+        std::vector<int> incident_edges;
+        x.reserve(d.vertex_count());
+        y.reserve(d.vertex_count());
+        incident_edges.reserve(d.vertex_count());
+        for (const auto& v : d.m_vertices) {
+            x.push_back(v.x());
+            y.push_back(v.y());
+            incident_edges.push_back(v.incident_edge());
+        }
+        section.x = w.write(x);
+        section.y = w.write(y);
+        section.incident_edges = w.write(incident_edges);
+
+        section.edge_origins = w.write(d.m_edge_origins);
+        section.edge_previous = w.write(d.m_edge_previous);
+        section.edge_next = w.write(d.m_edge_next);
+        section.edge_faces = w.write(d.m_edge_faces);
+
+        std::vector<int> face_edges;
+        face_edges.reserve(d.face_count());
+        for (const auto& f : d.m_faces) {
+            face_edges.push_back(f.edge());
+        }
+        section.face_edges = w.write(face_edges);
+        section.face_flags = w.write(d.m_face_flags);
+        section.free_edges = w.write(d.m_free_edges);
+        section.free_faces = w.write(d.m_free_faces);
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out) {
+        throw std::runtime_error("Cannot write snapshot file " + path);
+    }
+}
+
+snapshot::snapshot(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot open snapshot file " + path);
+    }
+    struct stat status;
+    if (::fstat(fd, &status) == -1 || status.st_size < (off_t)sizeof(snapshottype::header)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid snapshot file " + path);
+    }
+    m_size = status.st_size;
+    // the mapping stays valid when the descriptor is closed
+    m_data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_data == MAP_FAILED) {
+        m_data = nullptr;
+        throw std::runtime_error("Cannot map snapshot file " + path);
+    }
+
+    const auto* data = static_cast<const std::uint8_t*>(m_data);
+    const auto& header = *reinterpret_cast<const snapshottype::header*>(data);
+
+    // every array is inside the file and aligned
+    auto valid_array = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t size) {
+        return offset % ALIGNMENT == 0 && offset <= m_size && count * size <= m_size - offset;
+    };
+    auto valid_section = [&](const snapshottype::section& s) {
+        return valid_array(s.x, s.vertex_count, sizeof(util::coordinate)) &&
+               valid_array(s.y, s.vertex_count, sizeof(util::coordinate)) &&
+               valid_array(s.incident_edges, s.vertex_count, sizeof(int)) &&
+               valid_array(s.edge_origins, s.edge_count, sizeof(int)) &&
+               valid_array(s.edge_previous, s.edge_count, sizeof(int)) &&
+               valid_array(s.edge_next, s.edge_count, sizeof(int)) &&
+               valid_array(s.edge_faces, s.edge_count, sizeof(int)) &&
+               valid_array(s.face_edges, s.face_count, sizeof(int)) &&
+               valid_array(s.face_flags, s.face_count, sizeof(std::uint8_t)) &&
+               valid_array(s.free_edges, s.free_edge_count, sizeof(int)) &&
+               valid_array(s.free_faces, s.free_face_count, sizeof(int));
+    };
+
+    // ids in the arrays refer to elements of the arrays, so the views and copies read inside them,
+    // every id is read, but nothing is copied
+    auto valid_ids = [&](std::uint64_t offset, std::uint64_t count, auto valid_id) {
+        const auto* ids = reinterpret_cast<const int*>(data + offset);
+        return std::all_of(ids, ids + count, valid_id);
+    };
+    auto valid_section_ids = [&](const snapshottype::section& s) {
+        int vertex_count = s.vertex_count;
+        int edge_count = s.edge_count;
+        int face_count = s.face_count;
+        auto edge_id = [&](int id) { return id == -1 || (id >= 1 && id <= edge_count); };
+        // origin of a removed edge is 0, symbolic points have negative ids
+        auto origin = [&](int id) {
+            return id == dceltype::point_minus_1 || id == dceltype::point_minus_2 || (id >= 0 && id <= vertex_count);
+        };
+        auto face_id = [&](int id) { return id >= -1 && id < face_count; };
+        // free lists hold the first ids of pairs of edges and ids of faces
+        auto free_edge_id = [&](int id) { return id >= 1 && id < edge_count; };
+        auto free_face_id = [&](int id) { return id >= 1 && id < face_count; };
+
+        // twins are pairs of consecutive edges
+        return s.edge_count % 2 == 0 &&
+               valid_ids(s.incident_edges, s.vertex_count, edge_id) &&
+               valid_ids(s.edge_origins, s.edge_count, origin) &&
+               valid_ids(s.edge_previous, s.edge_count, edge_id) &&
+               valid_ids(s.edge_next, s.edge_count, edge_id) &&
+               valid_ids(s.edge_faces, s.edge_count, face_id) &&
+               valid_ids(s.face_edges, s.face_count, edge_id) &&
+               valid_ids(s.free_edges, s.free_edge_count, free_edge_id) &&
+               valid_ids(s.free_faces, s.free_face_count, free_face_id);
+    };
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != snapshottype::version ||
+        header.byte_order != byte_order || header.coordinate_size != sizeof(util::coordinate) ||
+        !valid_section(header.sections[0]) || !valid_section(header.sections[1]) ||
+        !valid_section_ids(header.sections[0]) || !valid_section_ids(header.sections[1])) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+        throw std::runtime_error("Invalid snapshot file " + path);
+    }
+
+    m_triangulation.m_section = header.sections[0];
+    m_triangulation.m_data = data;
+    m_voronoi.m_section = header.sections[1];
+    m_voronoi.m_data = data;
+}
+
+snapshot::~snapshot()
+{
+    if (m_data != nullptr) {
+        ::munmap(m_data, m_size);
+    }
+}
+
+const snapshottype::dcel_view& snapshot::triangulation() const
+{
+    return m_triangulation;
+}
+
+const snapshottype::dcel_view& snapshot::voronoi() const
+{
+    return m_voronoi;
+}
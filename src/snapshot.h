@@ -0,0 +1,130 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "dcel.h"
+#include "utility.h"
+
+// binary snapshot of a built triangulation and its voronoi graph
+//
+// the file is a header followed by the arrays of both dcels, every array starts
+// at a multiple of 64 bytes, so the file is mapped read-only and the arrays are
+// used in place, processes that map the same file share its pages
+//
+//   header | triangulation arrays | voronoi arrays
+//
+// arrays of a dcel: x, y and incident edges of vertices, origins, previous, next
+// and faces of edges, edges and flags of faces, free lists of edges and faces
+// the file is written in the native byte order and coordinate type, the loader
+// rejects files of a different version, byte order or coordinate type, and files
+// whose arrays are outside the file or hold ids outside the arrays
+//
+// dcel_view is the only path without copying, voronoi, convex_hull and
+// largest_empty_circle take a dcel, so they need the copy made by dcel_view::to_dcel
+
+namespace snapshottype {
+    // version of the file format, it is changed with the layout
+    constexpr std::uint32_t version = 1;
+
+    // counts and offsets (from the start of the file) of the arrays of one dcel
+    struct section {
+        std::uint32_t vertex_count;
+        std::uint32_t edge_count;
+        std::uint32_t face_count;
+        std::uint32_t free_edge_count;
+        std::uint32_t free_face_count;
+        std::uint32_t integral;
+        std::uint64_t x;
+        std::uint64_t y;
+        std::uint64_t incident_edges;
+        std::uint64_t edge_origins;
+        std::uint64_t edge_previous;
+        std::uint64_t edge_next;
+        std::uint64_t edge_faces;
+        std::uint64_t face_edges;
+        std::uint64_t face_flags;
+        std::uint64_t free_edges;
+        std::uint64_t free_faces;
+    };
+
+    struct header {
+        char magic[8];
+        std::uint32_t version;
+        // sizeof(util::coordinate)
+        std::uint32_t coordinate_size;
+        // 0x01020304 written in the native byte order
+        std::uint32_t byte_order;
+        std::uint32_t reserved;
+        // triangulation, voronoi graph
+        section sections[2];
+    };
+
+    // read-only dcel whose arrays are in the mapped file,
+    // ids and indices are the same as in the saved dcel
+    class dcel_view {
+    public:
+        int vertex_count() const;
+        int edge_count() const;
+        int face_count() const;
+
+        util::point point(int vertex_index) const;
+        int incident_edge(int vertex_index) const;
+
+        int origin(int edge_index) const;
+        int twin(int edge_index) const;
+        int previous(int edge_index) const;
+        int next(int edge_index) const;
+        int face(int edge_index) const;
+        bool edge_removed(int edge_index) const;
+
+        // id of an edge of the face
+        int face_edge(int face_id) const;
+        bool imaginary(int face_id) const;
+        bool bottom(int face_id) const;
+        bool hull_adjacent(int face_id) const;
+
+        // copies the arrays into a dcel that can be changed
+        dcel to_dcel() const;
+
+    private:
+        friend class ::snapshot;
+
+        section m_section{};
+        const std::uint8_t* m_data = nullptr;
+
+        template <typename T>
+        const T* array(std::uint64_t offset) const
+        {
+            return reinterpret_cast<const T*>(m_data + offset);
+        }
+    };
+}
+
+class snapshot {
+public:
+    // writes the triangulation and the voronoi graph to the file
+    // throws std::runtime_error if the file cannot be written
+    static void write(const std::string& path, const dcel& triangulation, const dcel& voronoi);
+
+    // maps the file read-only and checks the header and the ids in the arrays
+    // throws std::runtime_error if the file cannot be mapped or it is not a valid snapshot
+    explicit snapshot(const std::string& path);
+    ~snapshot();
+
+    snapshot(const snapshot&) = delete;
+    snapshot& operator=(const snapshot&) = delete;
+
+    const snapshottype::dcel_view& triangulation() const;
+    const snapshottype::dcel_view& voronoi() const;
+
+private:
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+    snapshottype::dcel_view m_triangulation;
+    snapshottype::dcel_view m_voronoi;
+};
+
+#endif /* SNAPSHOT_H */
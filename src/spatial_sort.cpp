@@ -0,0 +1,124 @@
+#include "spatial_sort.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+// hilbert curve is defined on a grid of 2^HILBERT_ORDER x 2^HILBERT_ORDER cells
+#define HILBERT_ORDER (16)
+// rounds smaller than this are merged into the first round
+#define BRIO_MIN_ROUND (64)
+// fixed seed, so the insertion order (and the triangulation) is reproducible
+#define BRIO_SEED (5489u)
+
+namespace {
+    // returns [min_x, max_x, min_y, max_y] of points [first, points.size())
+    std::vector<double> bounding_box(const std::vector<util::point>& points, int first)
+    {
+        std::vector<double> box{points[first].x(), points[first].x(), points[first].y(), points[first].y()};
+        for (int i = first+1; i < (int)points.size(); ++i) {
+            box[0] = std::min(box[0], points[i].x());
+            box[1] = std::max(box[1], points[i].x());
+            box[2] = std::min(box[2], points[i].y());
+            box[3] = std::max(box[3], points[i].y());
+        }
+        return box;
+    }
+
+    // sorts indices [begin, end) along the hilbert curve
+    void sort_by_hilbert_index(std::vector<int>::iterator begin, std::vector<int>::iterator end,
+                               const std::vector<std::uint64_t>& keys, int first)
+    {
+        std::sort(begin, end, [&](int lhs, int rhs) { return keys[lhs-first] < keys[rhs-first]; });
+    }
+
+    std::vector<std::uint64_t> hilbert_keys(const std::vector<util::point>& points, int first)
+    {
+        auto box = bounding_box(points, first);
+        std::vector<std::uint64_t> keys;
+        keys.reserve(points.size()-first);
+        for (int i = first; i < (int)points.size(); ++i) {
+            keys.emplace_back(util::hilbert_index(points[i], box[0], box[1], box[2], box[3]));
+        }
+        return keys;
+    }
+}
+
+std::uint64_t util::hilbert_index(point p, double min_x, double max_x, double min_y, double max_y)
+{
+    const std::uint32_t n = 1u << HILBERT_ORDER;
+
+    // map the point to the grid cell
+    auto to_grid = [n](double value, double min, double max) {
+        if (max <= min) {
+            return std::uint32_t{0};
+        }
+        double cell = (value - min) / (max - min) * (n - 1);
+        return (std::uint32_t)std::clamp(cell, 0.0, (double)(n - 1));
+    };
+
+    std::uint32_t x = to_grid(p.x(), min_x, max_x);
+    std::uint32_t y = to_grid(p.y(), min_y, max_y);
+
+    std::uint64_t d = 0;
+    for (std::uint32_t s = n/2; s > 0; s /= 2) {
+        std::uint32_t rx = (x & s) > 0;
+        std::uint32_t ry = (y & s) > 0;
+        d += (std::uint64_t)s * s * ((3 * rx) ^ ry);
+
+        // rotate the quadrant so the curve is continuous
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n-1 - x;
+                y = n-1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+
+    return d;
+}
+
+std::vector<int> util::hilbert_order(const std::vector<point>& points, int first)
+{
+    std::vector<int> order(points.size()-first);
+    std::iota(order.begin(), order.end(), first);
+
+    if (!order.empty()) {
+        sort_by_hilbert_index(order.begin(), order.end(), hilbert_keys(points, first), first);
+    }
+
+    return order;
+}
+
+std::vector<int> util::brio_order(const std::vector<point>& points, int first)
+{
+    std::vector<int> order(points.size()-first);
+    std::iota(order.begin(), order.end(), first);
+
+    if (order.empty()) {
+        return order;
+    }
+
+    auto keys = hilbert_keys(points, first);
+
+    std::mt19937 generator(BRIO_SEED);
+    std::shuffle(order.begin(), order.end(), generator);
+
+    // rounds are [0, n/2^k), ..., [n/4, n/2), [n/2, n)
+    // the last round has half of the points, the one before a quarter etc.
+    int round_end = order.size();
+    while (round_end > BRIO_MIN_ROUND) {
+        int round_begin = round_end / 2;
+        if (round_begin <= BRIO_MIN_ROUND) {
+            round_begin = 0;
+        }
+        sort_by_hilbert_index(order.begin() + round_begin, order.begin() + round_end, keys, first);
+        round_end = round_begin;
+    }
+
+    if (round_end > 0) {
+        sort_by_hilbert_index(order.begin(), order.begin() + round_end, keys, first);
+    }
+
+    return order;
+}
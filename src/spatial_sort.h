@@ -0,0 +1,25 @@
+#ifndef SPATIAL_SORT_H
+#define SPATIAL_SORT_H
+
+#include <vector>
+#include <cstdint>
+
+#include "utility.h"
+
+namespace util {
+    // returns index of point p on the hilbert curve that fills
+    // the bounding box [min_x, max_x]x[min_y, max_y]
+    std::uint64_t hilbert_index(point p, double min_x, double max_x, double min_y, double max_y);
+
+    // returns indices [first, points.size()) sorted along the hilbert curve
+    std::vector<int> hilbert_order(const std::vector<point>& points, int first = 0);
+
+    // returns indices [first, points.size()) in biased randomized insertion order:
+    // indices are shuffled and split into rounds of doubling size,
+    // and each round is sorted along the hilbert curve, so consecutive
+    // points are close to each other, but the order is still random enough
+    // for the incremental construction to run in expected O(n log n)
+    std::vector<int> brio_order(const std::vector<point>& points, int first = 0);
+}
+
+#endif /* SPATIAL_SORT_H */
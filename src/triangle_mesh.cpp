@@ -0,0 +1,134 @@
+#include "triangle_mesh.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+triangle_mesh::triangle_mesh(const dcel& triangulation)
+{
+    m_points.reserve(triangulation.vertex_count());
+    std::transform(triangulation.vertices().cbegin(), triangulation.vertices().cend(), std::back_inserter(m_points),
+            [](const auto& v) { return v.point(); });
+
+    // removed faces are skipped, so face id -> triangle index, -1 for the external and removed faces
+    std::vector<int> triangle_index(triangulation.face_count(), -1);
+    for (int face_id = 1; face_id < triangulation.face_count(); ++face_id) {
+        if (!triangulation.face_removed(face_id)) {
+            triangle_index[face_id] = m_vertices.size();
+            m_vertices.push_back({});
+        }
+    }
+    m_neighbours.resize(m_vertices.size());
+
+    // edge i of the face goes from vertex i to vertex i+1, so it is opposite to vertex i+2
+    for (int face_id = 1; face_id < triangulation.face_count(); ++face_id) {
+        int triangle = triangle_index[face_id];
+        if (triangle == -1) {
+            continue;
+        }
+        auto edge = triangulation.face_edge(face_id);
+        for (int i = 0; i < 3; ++i, edge = edge | edgerelation::next) {
+            m_vertices[triangle][i] = edge.origin();
+            m_neighbours[triangle][(i+2)%3] = triangle_index[(edge | edgerelation::twin).face()];
+        }
+    }
+}
+
+triangle_mesh::triangle_mesh(std::vector<util::point> points, std::vector<std::array<int,3>> triangles)
+    : m_points(std::move(points))
+    , m_vertices(std::move(triangles))
+    , m_neighbours(m_vertices.size(), {-1, -1, -1})
+{
+    // key of an undirected edge is (smaller id, bigger id)
+    auto key = [](int origin, int destination) {
+        return ((std::uint64_t)(std::uint32_t)std::min(origin, destination) << 32) | (std::uint32_t)std::max(origin, destination);
+    };
+
+    // (key, 3t+i) for the edge opposite to vertex i of triangle t sorted by key,
+    // so the edges shared by two triangles are adjacent
+    std::vector<std::pair<std::uint64_t, int>> edges;
+    edges.reserve(3*m_vertices.size());
+    for (int t = 0; t < (int)m_vertices.size(); ++t) {
+        for (int i = 0; i < 3; ++i) {
+            edges.emplace_back(key(m_vertices[t][(i+1)%3], m_vertices[t][(i+2)%3]), 3*t+i);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (int k = 0; k+1 < (int)edges.size(); ++k) {
+        if (edges[k].first == edges[k+1].first) {
+            int first = edges[k].second;
+            int second = edges[k+1].second;
+            m_neighbours[first/3][first%3] = second/3;
+            m_neighbours[second/3][second%3] = first/3;
+            ++k;
+        }
+    }
+}
+
+int triangle_mesh::vertex_count() const
+{
+    return m_points.size();
+}
+
+int triangle_mesh::triangle_count() const
+{
+    return m_vertices.size();
+}
+
+util::point triangle_mesh::point(int vertex_id) const
+{
+    assert(vertex_id > 0);
+    return m_points[vertex_id-1];
+}
+
+const std::vector<util::point>& triangle_mesh::points() const
+{
+    return m_points;
+}
+
+const std::array<int,3>& triangle_mesh::vertices(int triangle) const
+{
+    return m_vertices[triangle];
+}
+
+const std::array<int,3>& triangle_mesh::neighbours(int triangle) const
+{
+    return m_neighbours[triangle];
+}
+
+int triangle_mesh::index(int triangle, int vertex_id) const
+{
+    const auto& vertices = m_vertices[triangle];
+    return vertices[0] == vertex_id ? 0 : vertices[1] == vertex_id ? 1 : vertices[2] == vertex_id ? 2 : -1;
+}
+
+bool triangle_mesh::imaginary(int triangle) const
+{
+    const auto& vertices = m_vertices[triangle];
+    return vertices[0] < 0 || vertices[1] < 0 || vertices[2] < 0;
+}
+
+std::vector<util::line_segment> triangle_mesh::get_edges() const
+{
+    // edges of every real triangle in the order of the triangles,
+    // so the edges are the same as the ones of delaunay::get_edges
+    std::vector<util::line_segment> result;
+    for (int t = 0; t < triangle_count(); ++t) {
+        if (imaginary(t)) {
+            continue;
+        }
+        const auto& vertices = m_vertices[t];
+        for (int i = 0; i < 3; ++i) {
+            result.emplace_back(point(vertices[i]), point(vertices[(i+1)%3]));
+        }
+    }
+    return result;
+}
+
+dcel triangle_mesh::to_dcel() const
+{
+    dcel result(m_points);
+    result.add_triangles(m_vertices);
+    return result;
+}
@@ -0,0 +1,61 @@
+#ifndef TRIANGLE_MESH_H
+#define TRIANGLE_MESH_H
+
+#include <vector>
+#include <array>
+
+#include "dcel.h"
+#include "utility.h"
+
+class triangle_mesh {
+    // triangulation stored as triangles only, every triangle has 3 vertices ids
+    // and 3 neighbouring triangles, there are no edge and face records
+    //
+    //            v0
+    //            /\
+    //       n2  /  \  n1
+    //          /    \
+    //      v1 ------- v2
+    //             n0
+    //
+    // neighbour i is the triangle across the edge opposite to vertex i,
+    // vertices are in positive direction
+public:
+    // builds the mesh from the triangulation, the triangles are the faces of the dcel
+    // including the imaginary ones, so point_minus_2 and point_minus_1 can be vertices
+    triangle_mesh(const dcel& triangulation);
+    // triangles are given as vertices ids in positive direction as in dcel::add_triangles,
+    // neighbours are found by sorting the edges
+    triangle_mesh(std::vector<util::point> points, std::vector<std::array<int,3>> triangles);
+
+    int vertex_count() const;
+    int triangle_count() const;
+
+    // point of the vertex with the given id, it cannot be point_minus_2 or point_minus_1
+    util::point point(int vertex_id) const;
+    const std::vector<util::point>& points() const;
+
+    // vertices ids of the triangle with the given index
+    const std::array<int,3>& vertices(int triangle) const;
+    // indices of neighbouring triangles, -1 if the edge is on the boundary
+    const std::array<int,3>& neighbours(int triangle) const;
+    // returns i such that vertex i of the triangle has the given id, -1 if there is no such vertex
+    int index(int triangle, int vertex_id) const;
+    // returns true if the triangle has point_minus_1 and/or point_minus_2
+    bool imaginary(int triangle) const;
+
+    // returns edges of the triangulation without
+    // imaginary points point_minus_1 and point_minus_2
+    std::vector<util::line_segment> get_edges() const;
+
+    // builds dcel with the same vertices, triangle i becomes face i+1,
+    // so the mesh can be used where the dcel is expected
+    dcel to_dcel() const;
+
+private:
+    std::vector<util::point> m_points;
+    std::vector<std::array<int,3>> m_vertices;
+    std::vector<std::array<int,3>> m_neighbours;
+};
+
+#endif /* TRIANGLE_MESH_H */
@@ -1,21 +1,46 @@
 #include "utility.h"
+#include "predicates.h"
 #include <cmath>
 #include <iostream>
 #include <cassert>
 
 #define EPS (0.0001)
-#define COLLINEAR_THRESHOLD (0.000001)
+
+namespace {
+    // center of the circle through a, b and c is a + (ux,uy), where
+    // ux = (cy'|b'|² - by'|c'|²) / d, uy = (bx'|c'|² - cx'|b'|²) / d, d = 2(bx'cy' - by'cx'),
+    // and b' = b - a, c' = c - a
+    inline void circumcenter(double ax, double ay, double bx, double by, double cx, double cy, double& x, double& y)
+    {
+        double bax = bx - ax;
+        double bay = by - ay;
+        double cax = cx - ax;
+        double cay = cy - ay;
+        double b_lift = bax*bax + bay*bay;
+        double c_lift = cax*cax + cay*cay;
+        double d = 2*(bax*cay - bay*cax);
+        x = ax + (cay*b_lift - bay*c_lift) / d;
+        y = ay + (bax*c_lift - cax*b_lift) / d;
+    }
+}
 
 // point
 util::point::point(double x, double y)
-    : m_x(x)
-    , m_y(y)
+    : m_x(static_cast<coordinate>(x))
+    , m_y(static_cast<coordinate>(y))
 {
 }
 
 double util::point::distance(point p) const
 {
-    return std::sqrt(std::pow(p.x() - m_x, 2) + std::pow(p.y() - m_y, 2));
+    return std::sqrt(squared_distance(p));
+}
+
+double util::point::squared_distance(point p) const
+{
+    double dx = p.x() - x();
+    double dy = p.y() - y();
+    return dx*dx + dy*dy;
 }
 
 bool util::point::operator<(point other) const
@@ -30,7 +55,7 @@ bool util::point::operator>(point other) const
 
 bool util::point::operator==(point other) const
 {
-    return std::fabs(m_x-other.m_x) < EPS && std::fabs(m_y-other.m_y) < EPS;
+    return std::fabs(x()-other.x()) < EPS && std::fabs(y()-other.y()) < EPS;
 }
 
 bool util::point::operator!=(point other) const
@@ -48,16 +73,6 @@ bool util::point::operator>=(point other) const
     return *this > other || *this == other;
 }
 
-double util::point::x() const
-{
-    return m_x;
-}
-
-double util::point::y() const
-{
-    return m_y;
-}
-
 bool util::point::in_circle(point a, point b, point c) const
 {
     // Let d be a determinant
@@ -67,34 +82,23 @@ bool util::point::in_circle(point a, point b, point c) const
     // if d = 0, then (x,y) is on the circle,
     // if d > 0, then (x,y) is in the circle,
     // if d < 0, then (x,y) is outside the circle
-
-    double d11 = a.x()-m_x;
-    double d12 = a.y()-m_y;
-    double d13 = std::pow(a.x()-m_x,2) + std::pow(a.y()- m_y,2);
-
-    double d21 = b.x()-m_x;
-    double d22 = b.y()-m_y;
-    double d23 = std::pow(b.x()-m_x,2) + std::pow(b.y()- m_y,2);
-
-    double d31 = c.x()-m_x;
-    double d32 = c.y()-m_y;
-    double d33 = pow(c.x()-m_x,2) + pow(c.y()-m_y,2);
-
-    return d11*d22*d33 + d12*d23*d31 + d13*d21*d32 - d13*d22*d31 - d23*d32*d11 - d33*d12*d21 > 0.0;
+    // the sign of d is exact
+    return util::in_circle(a, b, c, *this) > 0.0;
 }
 
 double util::point::signed_area(point p, point q) const
 {
     // calculate signed area of triangle (this, p, q) using cross product
-    return  (-p.m_x*m_y + q.m_x*m_y + m_x*p.m_y - q.m_x*p.m_y - m_x*q.m_y + p.m_x*q.m_y)/2;
+    return  (-p.x()*y() + q.x()*y() + x()*p.y() - q.x()*p.y() - x()*q.y() + p.x()*q.y())/2;
 }
 
 util::direction util::point::get_direction(point p, point q) const
 {
-    double area = signed_area(p, q);
-    return (area > COLLINEAR_THRESHOLD) ? 
+    // the sign of the area is exact, so nearly collinear points are not collinear
+    double area = util::orient2d(*this, p, q);
+    return (area > 0.0) ? 
             direction::positive :
-           (area < -COLLINEAR_THRESHOLD) ? 
+           (area < 0.0) ? 
             direction::negative : 
             direction::collinear;
 }
@@ -125,21 +129,26 @@ std::ostream& util::operator<<(std::ostream& out, const util::point& p)
 }
 
 // circle
-util::circle::circle(util::point center, double r)
+util::circle::circle(util::point center, double r, radius_type type)
     : m_center(std::move(center))
-    , m_r(r)
+    , m_r2((type == radius_type::radius) ? r*r : r)
 {
 }
 
 util::circle::circle(util::point a, util::point b, util::point c)
     : m_center(get_center(a,b,c))
-    , m_r(m_center.distance(a))
+    , m_r2(m_center.squared_distance(a))
 {
 }
 
 double util::circle::r() const
 {
-    return m_r;
+    return std::sqrt(m_r2);
+}
+
+double util::circle::squared_r() const
+{
+    return m_r2;
 }
 
 util::point util::circle::center() const
@@ -149,23 +158,12 @@ util::point util::circle::center() const
 
 bool util::circle::operator==(const circle& other) const
 {
-    return m_center == other.m_center && std::fabs(m_r - other.m_r) < EPS;
+    return m_center == other.m_center && std::fabs(r() - other.r()) < EPS;
 }
 
 util::point util::circle::get_center(util::point a, util::point b, util::point c) const
 {
-    // point a, b and c shouldn't be collinear
-    assert(a.get_direction(b,c) != util::direction::collinear);
-
-    util::point ab_middle{(a.x() + b.x())/2, (a.y() + b.y())/2};
-    util::point bc_middle{(b.x() + c.x())/2, (b.y() + c.y())/2};
-    util::point rotated_1 = b.rotate_90(ab_middle);
-    util::point rotated_2 = c.rotate_90(bc_middle);
-    auto center = util::line(ab_middle, rotated_1).intersection_point(util::line(bc_middle, rotated_2));
-    //
-    // there should be an intersection point
-    assert(center);
-    return *center;
+    return util::circumcenter(a, b, c);
 }
 
 // line_segment
@@ -328,3 +326,21 @@ std::optional<util::point> util::line::intersection_point(util::line other) cons
     return std::optional<util::point>{util::point(o1x + t1*(d1x-o1x), o1y + t1*(d1y-o1y))};
 }
 
+util::point util::circumcenter(point a, point b, point c)
+{
+    // point a, b and c shouldn't be collinear
+    assert(a.get_direction(b,c) != util::direction::collinear);
+
+    double x, y;
+    ::circumcenter(a.x(), a.y(), b.x(), b.y(), c.x(), c.y(), x, y);
+    return {x, y};
+}
+
+void util::circumcenters(const double* ax, const double* ay, const double* bx, const double* by, 
+                         const double* cx, const double* cy, double* __restrict x, double* __restrict y, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        ::circumcenter(ax[i], ay[i], bx[i], by[i], cx[i], cy[i], x[i], y[i]);
+    }
+}
+
@@ -7,13 +7,24 @@
 
 namespace util {
     enum class direction { positive, negative, collinear };
+    // radius of a circle can be given as the radius or its square
+    enum class radius_type { radius, squared_radius };
+
+    // type of the stored coordinates, chosen at compile time
+    // floats halve the memory of points, computations are always done in doubles
+#ifdef SINGLE_PRECISION
+    using coordinate = float;
+#else
+    using coordinate = double;
+#endif
 
     class point {
     public:
         point(double x = 0, double y = 0);
 
-        double x() const;
-        double y() const;
+        // accessors are inline, they are used in the innermost loops of the triangulation
+        double x() const { return m_x; }
+        double y() const { return m_y; }
 
         bool operator<(point other) const;
         bool operator>(point other) const;
@@ -23,6 +34,8 @@ namespace util {
         bool operator>=(point other) const;
 
         double distance(point p) const;
+        // comparisons of distances don't need a square root
+        double squared_distance(point p) const;
         double signed_area(point p, point q) const;
         // returns direction of this - p - q
         direction get_direction(point p, point q) const;
@@ -36,17 +49,19 @@ namespace util {
         point rotate_90(point a) const;
 
     private:
-        double m_x;
-        double m_y;
+        coordinate m_x;
+        coordinate m_y;
     };
 
     class circle {
     public:
-        circle(point center = {}, double r = 0);
+        circle(point center = {}, double r = 0, radius_type type = radius_type::radius);
         circle(util::point a, util::point b, util::point c);
 
         point center() const;
         double r() const;
+        // circles are compared by the squared radius, r() takes the square root
+        double squared_r() const;
 
         bool operator==(const circle& other) const;
 
@@ -54,7 +69,9 @@ namespace util {
         point get_center(util::point a, util::point b, util::point c) const;
 
         point m_center;
-        double m_r;
+        // square of the radius, circles are results and not stored in bulk,
+        // so it is a double even if the coordinates are floats
+        double m_r2;
     };
 
     class line_segment {
@@ -86,6 +103,14 @@ namespace util {
     };
 
     std::ostream& operator<<(std::ostream& out, const util::point& p);
+
+    // returns center of the circle through a, b and c, points shouldn't be collinear
+    point circumcenter(point a, point b, point c);
+    // computes centers (x[i],y[i]) of the circles through (ax[i],ay[i]), (bx[i],by[i]) and (cx[i],cy[i]),
+    // the closed form has no branches, so the loop is vectorized by the compiler,
+    // x and y shouldn't overlap with the input arrays
+    void circumcenters(const double* ax, const double* ay, const double* bx, const double* by, 
+                       const double* cx, const double* cy, double* __restrict x, double* __restrict y, int count);
 }
 
 #endif /* UTILITY_H */
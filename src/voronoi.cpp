@@ -4,33 +4,316 @@
 #include <iostream>
 #include <algorithm>
 #include <limits>
+#include <numeric>
+#include <thread>
 
 #define INF (100000)
+// fewer circumcenters are computed on the current thread
+#define PARALLEL_MIN_FACES (4096)
+// fewer voronoi faces are built on the current thread
+#define PARALLEL_MIN_POINTS (4096)
 
-voronoi::voronoi(const dcel& triangulation)
+voronoi::voronoi(const dcel& triangulation, int threads)
     : m_triangulation(triangulation)
+{
+    build(threads);
+}
+
+voronoi::voronoi(const triangle_mesh& mesh, int threads)
+    : m_mesh_triangulation(std::make_unique<dcel>(mesh.to_dcel()))
+    , m_triangulation(*m_mesh_triangulation)
+{
+    build(threads);
+}
+
+void voronoi::build(int threads)
 {
     m_dcel.add(dceltype::face{-1});
+    m_dual_edges.assign((m_triangulation.edge_count()+1)/2, -1);
 
     // create voronoi vertices
-    circumcenters();
+    for (auto point : vertices(m_triangulation, threads)) {
+        m_dcel.add(dceltype::vertex{point});
+    }
+
+    threads = std::max(1, std::min(threads, m_triangulation.vertex_count() / PARALLEL_MIN_POINTS));
+    if (threads > 1) {
+        build_faces(threads);
+        return;
+    }
 
     // Compute Voronoi area for every point in Delaunay triangulation.
     for (int i=0; i < m_triangulation.vertex_count(); ++i) {
+        if (m_triangulation.vertex_removed(i)) {
+            // keep face ids equal to delaunay vertices ids
+            m_dcel.add(dceltype::face{-1});
+            continue;
+        }
+        add_point(i);
+    }
+}
+
+voronoitype::changes voronoi::update(const dceltype::changes& changes)
+{
+    voronoitype::changes result;
+
+    // removed delaunay faces are destroyed, but not created
+    std::vector<int> faces;
+    std::set_union(changes.created_faces.cbegin(), changes.created_faces.cend(), 
+                   changes.destroyed_faces.cbegin(), changes.destroyed_faces.cend(), std::back_inserter(faces));
+
+    // voronoi vertices of the changed delaunay faces, new faces get new vertices
+    while (m_dcel.vertex_count() < m_triangulation.face_count()-1) {
+        m_dcel.add(dceltype::vertex{util::point(INF, INF)});
+    }
+
+    for (int face_id : faces) {
+        if (m_triangulation.face_removed(face_id)) {
+            // vertex of removed face is not used
+            m_dcel.vertex(face_id-1) = {util::point(INF, INF)};
+            result.vertices.push_back(face_id);
+        }
+        else if (!m_triangulation.imaginary(face_id)) {
+            m_dcel.vertex(face_id-1) = {circumcenter(face_id)};
+            result.vertices.push_back(face_id);
+        }
+    }
+
+    // external centers depend on the incident real faces, so they are updated
+    // for changed imaginary faces and imaginary neighbours of changed real faces
+    std::vector<int> imaginary_faces;
+    for (int face_id : changes.created_faces) {
+        if (m_triangulation.imaginary(face_id)) {
+            imaginary_faces.push_back(face_id);
+            result.hull_changed = true;
+            continue;
+        }
+        if (!m_triangulation.hull_adjacent(face_id)) {
+            continue;
+        }
+        for (auto edge : m_triangulation.face_edges(face_id)) {
+            int neighbour_face_id = (edge | edgerelation::twin).face();
+            if (m_triangulation.imaginary(neighbour_face_id)) {
+                imaginary_faces.push_back(neighbour_face_id);
+            }
+        }
+    }
+    std::sort(imaginary_faces.begin(), imaginary_faces.end());
+    imaginary_faces.erase(std::unique(imaginary_faces.begin(), imaginary_faces.end()), imaginary_faces.end());
+
+    for (int face_id : imaginary_faces) {
+        // external face (0) has no voronoi vertex
+        if (face_id != 0 && !m_triangulation.bottom(face_id)) {
+            m_dcel.vertex(face_id-1) = {external_center(face_id)};
+            result.vertices.push_back(face_id);
+        }
+    }
+    std::sort(result.vertices.begin(), result.vertices.end());
+    result.vertices.erase(std::unique(result.vertices.begin(), result.vertices.end()), result.vertices.end());
+
+    // voronoi faces of delaunay vertices of the changed faces are rebuilt,
+    // faces of the other vertices are not changed
+    // pending flags are cleared when faces are rebuilt, so they are not reset for every update
+    m_pending.resize(m_triangulation.vertex_count(), false);
+    std::vector<int> rebuilt_points;
+    for (int face_id : changes.created_faces) {
+        for (int id : m_triangulation.triangle_ids(face_id)) {
+            if (id > 0 && !m_pending[id-1]) {
+                m_pending[id-1] = true;
+                rebuilt_points.push_back(id-1);
+            }
+        }
+    }
+    std::sort(rebuilt_points.begin(), rebuilt_points.end());
+
+    // edges between two rebuilt faces are created again and edges of
+    // the removed vertex face are removed, so their slots are reused
+    auto removed = [&](int vertex_id) {
+        return m_triangulation.vertex_removed(vertex_id-1) && vertex_id < m_dcel.face_count() && !m_dcel.face_removed(vertex_id);
+    };
+    std::vector<int> removed_edges;
+    for (int i : rebuilt_points) {
+        if (i+1 >= m_dcel.face_count()) {
+            // new point has no face yet
+            continue;
+        }
+        auto edge = m_dcel.edge(m_dcel.face(i+1).edge()-1);
+        int first_edge_id = edge.id();
+        do {
+            int neighbour_id = (edge | edgerelation::twin).face();
+            if ((neighbour_id > i+1 && m_pending[neighbour_id-1]) || removed(neighbour_id)) {
+                // twin is removed with the edge
+                removed_edges.push_back(edge.id());
+            }
+            edge = edge | edgerelation::next;
+        } while (edge.id() != first_edge_id);
+    }
+
+    if (removed(changes.vertex_id)) {
+        m_dcel.remove_face(changes.vertex_id);
+    }
+    for (int edge_id : removed_edges) {
+        m_dcel.remove_edge(edge_id);
+    }
+
+    // dual edges of the kept voronoi edges are not changed, as their delaunay edges are not changed
+    m_dual_edges.resize((m_triangulation.edge_count()+1)/2, -1);
+    m_created_edges.clear();
+    for (int i : rebuilt_points) {
         add_point(i);
+        m_pending[i] = false;
+    }
+    result.edges = m_created_edges;
+
+    return result;
+}
+
+int voronoi::dual_edge(int delaunay_edge_id) const
+{
+    int first_dual_edge_id = m_dual_edges[(delaunay_edge_id-1)/2];
+    if (first_dual_edge_id == -1) {
+        return -1;
     }
+    // the second delaunay edge of the pair is dual to the twin
+    return (delaunay_edge_id % 2 == 1) ? first_dual_edge_id : dceltype::twin(first_dual_edge_id);
+}
+
+void voronoi::build_faces(int threads)
+{
+    // add_point creates a pair of twins when the face of the point with the lower index is built,
+    // so pairs of a point follow the pairs of all previous points in the order of its out edges,
+    // points are split into parts, and a part needs only the number of pairs of the previous parts
+    //
+    // 1. every part counts its pairs
+    // 2. every part sets origins of its pairs and their dual delaunay edges
+    // 3. every part links edges of its faces and sets incident edges of its vertices
+    //
+    // threads write different edges, faces and vertices, so there are no locks
+    int point_count = m_triangulation.vertex_count();
+    int vertex_count = m_dcel.vertex_count();
+    auto begin = [&](int part, int count) {
+        return (int)((long long)count * part / threads);
+    };
+    auto run = [&](auto compute) {
+        std::vector<std::thread> workers;
+        for (int part = 1; part < threads; ++part) {
+            workers.emplace_back(compute, part);
+        }
+        compute(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+    // returns true if the point creates the pair dual to its out edge
+    auto creates = [&](int point_index, dcel::edgeref<true> edge) {
+        return !edge.has_negative_vertex() && (edge | edgerelation::twin).origin()-1 > point_index;
+    };
+
+    // pairs created by the previous parts
+    std::vector<int> pair_offsets(threads+1, 0);
+    run([&](int part) {
+        int pair_count = 0;
+        for (int i = begin(part, point_count); i < begin(part+1, point_count); ++i) {
+            if (!m_triangulation.vertex_removed(i)) {
+                for (auto edge : out_edges(m_triangulation, i)) {
+                    pair_count += creates(i, edge);
+                }
+            }
+        }
+        pair_offsets[part+1] = pair_count;
+    });
+    std::partial_sum(pair_offsets.begin(), pair_offsets.end(), pair_offsets.begin());
+
+    int first_edge_id = m_dcel.add_edges(pair_offsets[threads]);
+    for (int i = 0; i < point_count; ++i) {
+        m_dcel.add(dceltype::face{-1});
+    }
+
+    run([&](int part) {
+        int edge_id = first_edge_id + 2*pair_offsets[part];
+        for (int i = begin(part, point_count); i < begin(part+1, point_count); ++i) {
+            if (m_triangulation.vertex_removed(i)) {
+                continue;
+            }
+            for (auto edge : out_edges(m_triangulation, i)) {
+                if (creates(i, edge)) {
+                    m_dual_edges[(edge.id()-1)/2] = (edge.id() % 2 == 1) ? edge_id : edge_id+1;
+                    m_dcel.edge(edge_id-1).set_origin((edge | edgerelation::twin).face());
+                    m_dcel.edge(edge_id).set_origin(edge.face());
+                    edge_id += 2;
+                }
+            }
+        }
+    });
+
+    run([&](int part) {
+        for (int i = begin(part, point_count); i < begin(part+1, point_count); ++i) {
+            if (m_triangulation.vertex_removed(i)) {
+                continue;
+            }
+            int first_edge_id = -1;
+            int previous_edge_id = -1;
+            for (auto edge : out_edges(m_triangulation, i)) {
+                if (edge.has_negative_vertex()) {
+                    continue;
+                }
+                auto voronoi_edge = m_dcel.edge(dual_edge(edge.id())-1);
+                voronoi_edge.set_previous(previous_edge_id);
+                voronoi_edge.set_face(i+1);
+                if (previous_edge_id != -1) {
+                    m_dcel.edge(previous_edge_id-1).set_next(voronoi_edge.id());
+                }
+                else {
+                    first_edge_id = voronoi_edge.id();
+                }
+                previous_edge_id = voronoi_edge.id();
+            }
+            m_dcel.edge(first_edge_id-1).set_previous(previous_edge_id);
+            m_dcel.edge(previous_edge_id-1).set_next(first_edge_id);
+            m_dcel.face(i+1).set_edge(first_edge_id);
+        }
+
+        // add_point sets the incident edge of a vertex whenever it creates a pair with the vertex,
+        // so the vertex gets its edge of the pair with the highest id,
+        // edges of the vertex are dual to twins of the edges of its delaunay face
+        for (int vertex_id = begin(part, vertex_count)+1; vertex_id <= begin(part+1, vertex_count); ++vertex_id) {
+            if (m_triangulation.face_removed(vertex_id)) {
+                continue;
+            }
+            int incident_edge_id = -1;
+            for (auto edge : m_triangulation.face_edges(vertex_id)) {
+                if (!edge.has_negative_vertex()) {
+                    incident_edge_id = std::max(incident_edge_id, dual_edge(edge.twin()));
+                }
+            }
+            if (incident_edge_id != -1) {
+                m_dcel.vertex(vertex_id-1).set_incident_edge(incident_edge_id);
+            }
+        }
+    });
+}
+
+dcel::edge_range voronoi::out_edges(const dcel& triangulation, int point_index)
+{
+    auto first_edge = triangulation.edge(triangulation.vertex(point_index).incident_edge()-1);
+    while (triangulation.imaginary(first_edge.face()) || first_edge.external()) {
+        first_edge = first_edge | edgerelation::previous | edgerelation::twin;
+    }
+    return {first_edge, dcel::edge_range::circulation::vertex};
+}
+
+bool voronoi::face_exists(int point_index, int other_point_index) const
+{
+    // faces are built in the order of points indices, unless they are rebuilt by update
+    return m_pending.empty() ? other_point_index < point_index : !m_pending[other_point_index];
 }
 
 void voronoi::add_point(int point_index)
 {
-    int new_edge_id = m_dcel.edge_count()+1;
-    int newVoronoiFaceId = m_dcel.face_count();
+    int newVoronoiFaceId = point_index+1;
 
     // Get edge departing from point.
-    auto current_edge = m_triangulation.edge(m_triangulation.vertex(point_index).incident_edge()-1);
-    while (m_triangulation.imaginary(current_edge.face()) || current_edge.external()) {
-        current_edge = current_edge | edgerelation::previous | edgerelation::twin;
-    }
+    auto current_edge = *out_edges(m_triangulation, point_index).begin();
     auto first_processed_edge_id = current_edge.id();
 
     int previous_edge_id = -1;
@@ -47,21 +330,15 @@ void voronoi::add_point(int point_index)
             int edge_destination = (current_edge | edgerelation::twin).origin();
 
             // Check if Voronoi edge already created.
-            if (edge_destination < current_edge.origin()) {
-                // Get one of the edges of existing Voronoi face.
-                auto existing_edge = m_dcel.edge(m_dcel.face(edge_destination).edge() - 1);
-
-                // Loop until existing edge is found.
-                while (voronoiDestId != existing_edge.origin()) {
-                    existing_edge = existing_edge | edgerelation::next;
-                }
-
-                // Get twin of existing Voronoi edge (now existing edge is in current Voronoi face!!!!).
-                existing_edge = existing_edge | edgerelation::twin;
+            if (face_exists(point_index, edge_destination-1)) {
+                // Existing edge was created as the twin when the face of the destination was built,
+                // it is in the current Voronoi face.
+                auto existing_edge = m_dcel.edge(dual_edge(current_edge.id())-1);
+                assert(existing_edge.origin() == voronoiOriginId);
 
                 // Update existing edge.
                 existing_edge.set_previous(previous_edge_id);
-                existing_edge.set_next(new_edge_id);
+                existing_edge.set_next(-1);
                 existing_edge.set_face(newVoronoiFaceId);
 
                 if (previous_edge_id != -1) {
@@ -79,22 +356,43 @@ void voronoi::add_point(int point_index)
             // Current and twin edge did not exist -> create new edge and its twin.
             else
             {
+                int new_edge_id = m_dcel.new_edge();
+                int new_twin_id = new_edge_id+1;
+                if (!m_pending.empty()) {
+                    m_created_edges.push_back(new_edge_id);
+                }
+
                 // If first edge inserted -> save its id.
                 if (first_porcessed_edge_id == -1) {
                     first_porcessed_edge_id = new_edge_id;
                 }
 
-                // Add edge and its twin.
-                m_dcel.add(dceltype::edge{voronoiOriginId, new_edge_id + 1, previous_edge_id, new_edge_id + 2, newVoronoiFaceId});
-                m_dcel.add(dceltype::edge{voronoiDestId, new_edge_id, -1, -1, -1});
+                // Set edge and its twin, next edge is set when it is processed.
+                auto new_edge = m_dcel.edge(new_edge_id-1);
+                new_edge.set_origin(voronoiOriginId);
+                new_edge.set_previous(previous_edge_id);
+                new_edge.set_next(-1);
+                new_edge.set_face(newVoronoiFaceId);
+
+                auto new_twin = m_dcel.edge(new_twin_id-1);
+                new_twin.set_origin(voronoiDestId);
+                new_twin.set_previous(-1);
+                new_twin.set_next(-1);
+                new_twin.set_face(-1);
+
+                if (previous_edge_id != -1) {
+                    m_dcel.edge(previous_edge_id-1).set_next(new_edge_id);
+                }
+
+                // Edge of the current face is dual to the current delaunay edge.
+                m_dual_edges[(current_edge.id()-1)/2] = (current_edge.id() % 2 == 1) ? new_edge_id : new_twin_id;
 
                 // Update points.
                 m_dcel.vertex(voronoiOriginId - 1).set_incident_edge(new_edge_id);
-                m_dcel.vertex(voronoiDestId - 1).set_incident_edge(new_edge_id+1);
+                m_dcel.vertex(voronoiDestId - 1).set_incident_edge(new_twin_id);
 
-                // Update prvious and next edges id.
+                // Update prvious edge id.
                 previous_edge_id = new_edge_id;
-                new_edge_id = new_edge_id + 2;
             }
         }
         // Update current edge and its index.
@@ -105,10 +403,17 @@ void voronoi::add_point(int point_index)
     m_dcel.edge(first_porcessed_edge_id-1).set_previous(previous_edge_id);
     // Update "next" edge for last inserted edge.
     m_dcel.edge(previous_edge_id-1).set_next(first_porcessed_edge_id);
-    m_dcel.add(dceltype::face(first_porcessed_edge_id));
+
+    if (newVoronoiFaceId < m_dcel.face_count()) {
+        // face is rebuilt
+        m_dcel.face(newVoronoiFaceId).set_edge(first_porcessed_edge_id);
+    }
+    else {
+        m_dcel.add(dceltype::face(first_porcessed_edge_id));
+    }
 }
 
-void voronoi::circumcenters()
+std::vector<util::point> voronoi::vertices(const dcel& triangulation, int threads)
 {
     // voronoi vertices are created from circumcentres of delaunay's trinagles
     // we will create vertices such that its ids correspond to delaunay faces ids
@@ -125,17 +430,30 @@ void voronoi::circumcenters()
     // that it is not incident to any real face, and voronoi vertex for it will be invalid and it
     // will not be used; we create voronoi vertex for that traingle just to keep id relation between
     // voronoi vertices ids and delaunay faces ids
+    std::vector<util::point> result;
     int	last_imaginary_face = 0;
+    // ids of real faces and coordinates of their vertices, 
+    // their circumcenters are computed together below
+    std::vector<int> real_faces;
+    std::array<std::vector<double>,6> coordinates;
 
     // external face (0) has no circumcenter
-    for (int face_id = 1; face_id < m_triangulation.face_count(); ++face_id) {
-        if (!m_triangulation.imaginary(face_id)) {
+    for (int face_id = 1; face_id < triangulation.face_count(); ++face_id) {
+        if (triangulation.face_removed(face_id)) {
+            // keep vertices ids equal to delaunay faces ids
+            result.emplace_back(INF, INF);
+        }
+        else if (!triangulation.imaginary(face_id)) {
             // face is not imaginary - it is not an external face (0)
             // and has only real points
-            auto triangle_points = m_triangulation.points(face_id);
-            assert(triangle_points.size() == 3);
-            util::circle circle{triangle_points[0], triangle_points[1], triangle_points[2]};
-            m_dcel.add(dceltype::vertex{circle.center()});
+            auto points = triangulation.triangle_points(face_id);
+            for (int i = 0; i < 3; ++i) {
+                coordinates[2*i].push_back(points[i].x());
+                coordinates[2*i+1].push_back(points[i].y());
+            }
+            real_faces.push_back(face_id);
+            // circumcenter is set below
+            result.emplace_back(INF, INF);
         }
         else
         {
@@ -143,37 +461,74 @@ void voronoi::circumcenters()
             // or has point_minus_1 and/or point_minus_2
             last_imaginary_face = face_id;
             // add an inifinity point now, it will be updated below
-            m_dcel.add(dceltype::vertex{util::point(INF, INF)});
+            result.emplace_back(INF, INF);
         }
     }
 
+    // real faces are split into parts of the same size, one for each thread
+    int count = real_faces.size();
+    threads = std::max(1, std::min(threads, count / PARALLEL_MIN_FACES));
+    std::vector<double> x(count), y(count);
+    auto compute = [&](int part) {
+        int begin = (long long)count * part / threads;
+        int end = (long long)count * (part + 1) / threads;
+        util::circumcenters(coordinates[0].data() + begin, coordinates[1].data() + begin, 
+                            coordinates[2].data() + begin, coordinates[3].data() + begin,
+                            coordinates[4].data() + begin, coordinates[5].data() + begin, 
+                            x.data() + begin, y.data() + begin, end - begin);
+    };
+
+    std::vector<std::thread> workers;
+    for (int part = 1; part < threads; ++part) {
+        workers.emplace_back(compute, part);
+    }
+    compute(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (int i = 0; i < count; ++i) {
+        result[real_faces[i]-1] = {x[i], y[i]};
+    }
+
     // create imaginary faces circumcenters
     for (int face_id=1; face_id <= last_imaginary_face; ++face_id) {
-        if (m_triangulation.imaginary(face_id) && !m_triangulation.bottom(face_id)) {
+        if (!triangulation.face_removed(face_id) && triangulation.imaginary(face_id) && !triangulation.bottom(face_id)) {
             // face is imaginary and doesn't contain both p_minus_2 and p_minus_1
-            auto edge = m_triangulation.face_edge(face_id);
-
-            // find incident real face
-            int neighbour_face_id = 0;
-            while (true) {
-                // check if twin edge belongs to real delaunay face
-                neighbour_face_id = (edge | edgerelation::twin).face();
-                if (!m_triangulation.imaginary(neighbour_face_id)) {
-                    break;
-                }
-                else {
-                    edge = edge | edgerelation::next;
-                }
-            }
-
-            // circumcenter of the incident real face
-            auto center = m_dcel.vertex(neighbour_face_id-1).point();
-            m_dcel.vertex(face_id-1) = {get_external_center(edge, center)};
+            auto edge = real_neighbour_edge(triangulation, face_id);
+            result[face_id-1] = get_external_center(edge, result[(edge | edgerelation::twin).face()-1]);
         }
     }
+
+    return result;
 }
 
-util::point voronoi::get_external_center(dcel::edgeref<true> edge, util::point center) const
+util::point voronoi::circumcenter(int face_id) const
+{
+    auto triangle_points = m_triangulation.triangle_points(face_id);
+    return util::circumcenter(triangle_points[0], triangle_points[1], triangle_points[2]);
+}
+
+util::point voronoi::external_center(int face_id) const
+{
+    auto edge = real_neighbour_edge(m_triangulation, face_id);
+    // circumcenter of the incident real face
+    auto center = m_dcel.vertex((edge | edgerelation::twin).face()-1).point();
+    return get_external_center(edge, center);
+}
+
+dcel::edgeref<true> voronoi::real_neighbour_edge(const dcel& triangulation, int face_id)
+{
+    auto edge = triangulation.face_edge(face_id);
+
+    // find incident real face, twin edge belongs to it
+    while (triangulation.imaginary((edge | edgerelation::twin).face())) {
+        edge = edge | edgerelation::next;
+    }
+    return edge;
+}
+
+util::point voronoi::get_external_center(dcel::edgeref<true> edge, util::point center)
 {
     auto origin = edge.point();
     auto destination = (edge | edgerelation::twin).point();
@@ -205,9 +560,12 @@ std::vector<util::line_segment> voronoi::get_edges() const
 {
     std::vector<util::line_segment> result;
 
-    // skip twin edges
-    for (int i = 0; i < m_dcel.edge_count(); i += 2) {
+    // skip removed and twin edges
+    for (int i = 0; i < m_dcel.edge_count(); ++i) {
         auto edge = m_dcel.edge(i);
+        if (m_dcel.edge_removed(i) || edge.twin() < edge.id()) {
+            continue;
+        }
         auto origin = edge.point();
         auto destination = (edge | edgerelation::twin).point();
         if (origin != destination) {
@@ -227,8 +585,8 @@ std::vector<double> voronoi::range() const
 
     for (int i = 0; i < m_dcel.vertex_count(); ++i) {
         // vertex id = delaunay face id = i+1
-        if (m_triangulation.imaginary(i+1)) {
-            // skip points at infinity
+        if (m_triangulation.face_removed(i+1) || m_triangulation.imaginary(i+1)) {
+            // skip points at infinity and vertices of removed faces
             continue;
         }
         xmin = std::min(xmin, m_dcel.vertex(i).point().x());
@@ -244,3 +602,8 @@ const dcel& voronoi::graph() const
 {
     return m_dcel;
 }
+
+const dcel& voronoi::triangulation() const
+{
+    return m_triangulation;
+}
@@ -1,18 +1,59 @@
 #ifndef VORONOI_H
 #define VORONOI_H 
 
+#include <memory>
+
 #include "dcel.h"
+#include "triangle_mesh.h"
 #include "utility.h"
 
+namespace voronoitype {
+    // parts of the voronoi graph changed by update
+    struct changes {
+        // ids of moved and added voronoi vertices, sorted
+        std::vector<int> vertices;
+        // ids of rebuilt edges, every edge is given once without its twin
+        std::vector<int> edges;
+        // true if an imaginary delaunay face changed, so the convex hull could change
+        bool hull_changed = false;
+    };
+}
+
 class voronoi {
 public:
-    voronoi(const dcel& triangulation);
+    // circumcenters of the delaunay triangles and faces of the graph are computed
+    // on the given number of threads, the graph is the same for any number of threads
+    voronoi(const dcel& triangulation, int threads = 1);
+    // the mesh is converted to dcel that is owned by the voronoi graph,
+    // voronoi vertex id is the index of the triangle + 1
+    voronoi(const triangle_mesh& mesh, int threads = 1);
 
     const dcel& graph() const;
+    // returns triangulation the graph is built from, it is the dcel converted from the mesh
+    // if the graph is built from a mesh, so it can be shared with largest_empty_circle
+    const dcel& triangulation() const;
+
+    // updates the graph after a point is added to or a vertex is removed from the triangulation
+    // removed edges of the graph are reused
+    voronoitype::changes update(const dceltype::changes& changes);
+
+    // returns id of the voronoi edge dual to the delaunay edge with the given id,
+    // the voronoi edge is in the face of the origin of the delaunay edge and it goes
+    // from the vertex of the twin's face to the vertex of the edge's face,
+    // -1 if the delaunay edge has an imaginary vertex
+    int dual_edge(int delaunay_edge_id) const;
 
     // returns voronoi edges
     std::vector<util::line_segment> get_edges() const;
 
+    // returns voronoi vertices computed on the given number of threads, vertex for the delaunay face
+    // with id i is at index i-1, vertices of imaginary faces are far away, vertices of removed
+    // and bottom faces are not used
+    static std::vector<util::point> vertices(const dcel& triangulation, int threads = 1);
+    // returns delaunay edges out of the point starting from the first one in a real face,
+    // the voronoi face of the point has the edges dual to them in this order
+    static dcel::edge_range out_edges(const dcel& triangulation, int point_index);
+
     // returns [min_x, max_x, min_y, max_y]
     // so we can determine the range of
     // coordinate system when drawing voronoi diagram
@@ -20,19 +61,43 @@ public:
     std::vector<double> range() const;
 
 private:
-    // get voronoi vertices from delaunay triangles
-    void circumcenters();
+    // builds the graph from the triangulation
+    void build(int threads);
+    // get voronoi vertex for real delaunay face
+    util::point circumcenter(int face_id) const;
+    // get voronoi vertex for imaginary delaunay face from its incident real face
+    util::point external_center(int face_id) const;
+    // get edge of imaginary delaunay face whose twin is in a real face
+    static dcel::edgeref<true> real_neighbour_edge(const dcel& triangulation, int face_id);
     // get voronoi vertex for imaginary delaunay face
-    util::point get_external_center(dcel::edgeref<true> edge, util::point centre) const;
+    static util::point get_external_center(dcel::edgeref<true> edge, util::point centre);
+
+    // builds faces of all points on the given number of threads,
+    // edges get the same ids as they get from add_point
+    void build_faces(int threads);
 
     // add new point to the current voronoi graph
     // when all points are added, we will have voronoi graph
     void add_point(int point_index);
+    // returns true if voronoi face of other point is already built,
+    // so it has the edge shared with the face of the point
+    bool face_exists(int point_index, int other_point_index) const;
 
+    // delaunay triangulation converted from the mesh, null if the graph is built from dcel,
+    // it is on the heap, so the reference to it stays valid when the graph is moved
+    std::unique_ptr<dcel> m_mesh_triangulation;
     // delaunay triangulation
     const dcel& m_triangulation;
     // voronoi graph
     dcel m_dcel;
+    // flags of delaunay points whose faces are to be rebuilt by update,
+    // it is empty until the first update
+    std::vector<bool> m_pending;
+    // ids of edges created by the current update, without twins
+    std::vector<int> m_created_edges;
+    // voronoi edge id dual to the first delaunay edge of each pair of twins,
+    // the second delaunay edge is dual to its twin, -1 if there is no dual edge
+    std::vector<int> m_dual_edges;
 };
 
 #endif /* VORONOI_H */
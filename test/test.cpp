@@ -1,15 +1,49 @@
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
 #include <gtest/gtest.h>
 #include "../src/dcel.h"
 #include "../src/graph.h"
 #include "../src/delaunay.h"
 #include "../src/voronoi.h"
+#include "../src/compact_voronoi.h"
+#include "../src/clipped_voronoi.h"
+#include "../src/lloyd.h"
 #include "../src/convex_hull.h"
 #include "../src/largest_empty_circle.h"
+#include "../src/spatial_sort.h"
+#include "../src/predicates.h"
+#include "../src/snapshot.h"
 
 #define EPS (0.0001)
 
+// returns pseudo random points from [0,100]x[0,100]
+std::vector<util::point> random_points(int n, unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> distribution(0, 100);
+    std::vector<util::point> points;
+    for (int i = 0; i < n; ++i) {
+        double x = distribution(generator);
+        double y = distribution(generator);
+        points.emplace_back(x, y);
+    }
+    return points;
+}
+
+// returns true if both vectors have the same line segments, in any order
+bool same_edges(const std::vector<util::line_segment>& lhs, const std::vector<util::line_segment>& rhs)
+{
+    return lhs.size() == rhs.size() && std::all_of(lhs.begin(), lhs.end(), [&](const auto& e) { 
+               return std::find(rhs.begin(), rhs.end(), e) != rhs.end();
+           });
+}
+
 // test: point 
 TEST(point, comparison) 
 {
@@ -90,6 +124,82 @@ TEST(point, direction)
     ASSERT_EQ(util::point(4.5,8).get_direction({10,3.4}, {2.8,1}), util::direction::negative);
 }
 
+// points of these tests are not representable as floats
+#ifndef SINGLE_PRECISION
+TEST(point, direction_near_collinear) 
+{
+    // points p on a tiny grid near the line y = x, p - (12,12) - (24,24) is in positive
+    // direction iff p is above the line, the rounded determinant is wrong for some of them
+    const double u = std::ldexp(1.0, -53);
+    for (int i = 0; i < 32; ++i) {
+        for (int j = 0; j < 32; ++j) {
+            util::point p(0.5 + i*u, 0.5 + j*u);
+            auto expected = (j > i) ? util::direction::positive : 
+                            (j < i) ? util::direction::negative : 
+                                      util::direction::collinear;
+            ASSERT_EQ(p.get_direction({12,12}, {24,24}), expected);
+        }
+    }
+
+    // points that are collinear in decimal are not collinear as doubles
+    ASSERT_NE(util::point(0.2,1.6).get_direction({1.2,2.6}, {2,3.4}), util::direction::collinear);
+}
+
+TEST(point, in_circle_exact) 
+{
+    // (0,0), (1,0), (1,1) and (0,1) are on the same circle
+    ASSERT_EQ(util::in_circle({0,0}, {1,0}, {1,1}, {0,1}), 0.0);
+    ASSERT_FALSE(util::point(0,1).in_circle({0,0}, {1,0}, {1,1}));
+
+    // moved by one ulp into and out of the circle, far from the origin
+    const double offset = 1 << 30;
+    const double ulp = std::ldexp(1.0, -22);
+    util::point a{offset, offset}, b{offset+1, offset}, c{offset+1, offset+1};
+    ASSERT_TRUE(util::point(offset, offset+1-ulp).in_circle(a, b, c));
+    ASSERT_FALSE(util::point(offset, offset+1+ulp).in_circle(a, b, c));
+    ASSERT_GT(util::in_circle(a, b, c, {offset, offset+1-ulp}), 0.0);
+    ASSERT_LT(util::in_circle(a, b, c, {offset, offset+1+ulp}), 0.0);
+}
+#endif
+
+TEST(point, integer_predicates) 
+{
+    ASSERT_TRUE(util::integral({3, -4}));
+    ASSERT_FALSE(util::integral({0.5, 1}));
+    ASSERT_FALSE(util::integral({1e10, 1}));
+
+    // (5,0), (4,3), (3,4) and (0,5) are on the circle around the origin
+    ASSERT_EQ(util::in_circle_integer({5,0}, {4,3}, {3,4}, {0,5}), 0);
+    ASSERT_EQ(util::in_circle_integer({5,0}, {4,3}, {3,4}, {0,4}), 1);
+    ASSERT_EQ(util::in_circle_integer({5,0}, {4,3}, {3,4}, {0,6}), -1);
+    ASSERT_EQ(util::orient2d_integer({0,0}, {2,2}, {3,3}), 0);
+
+    // the signs are the same as of the floating point predicates, also for the biggest coordinates
+    std::mt19937 generator(7);
+    const int max = static_cast<int>(util::predicates::max_integer);
+    for (int range : {4, 1000, max}) {
+        std::uniform_int_distribution<int> distribution(-range, range);
+        auto random_point = [&]() { return util::point(distribution(generator), distribution(generator)); };
+        for (int i = 0; i < 1000; ++i) {
+            util::point a = random_point(), b = random_point(), c = random_point(), d = random_point();
+            ASSERT_TRUE(util::integral(a));
+            double area = util::orient2d(a, b, c);
+            ASSERT_EQ(util::orient2d_integer(a, b, c) > 0, area > 0.0);
+            ASSERT_EQ(util::orient2d_integer(a, b, c) < 0, area < 0.0);
+            double circle = util::in_circle(a, b, c, d);
+            ASSERT_EQ(util::in_circle_integer(a, b, c, d), (circle > 0.0) - (circle < 0.0));
+        }
+    }
+}
+
+TEST(point, coordinate) 
+{
+    // coordinates are stored as util::coordinate and read as doubles
+    ASSERT_EQ(sizeof(util::point), 2*sizeof(util::coordinate));
+    ASSERT_EQ(util::point(0.1, 0.2).x(), static_cast<double>(static_cast<util::coordinate>(0.1)));
+    ASSERT_EQ(util::point(0.1, 0.2).y(), static_cast<double>(static_cast<util::coordinate>(0.2)));
+}
+
 // test:line_segment
 TEST(line_segment, intersection_point) 
 {
@@ -394,6 +504,25 @@ TEST(circle, creation)
 
     c = util::circle ({1,10}, {2,5}, {3,6});
     ASSERT_EQ(c, util::circle({2.0/3,22.0/3}, 2.6874));
+
+    // radius can be given squared
+    ASSERT_EQ(util::circle({3,4}, 25, util::radius_type::squared_radius), util::circle({3,4}, 5));
+    ASSERT_EQ(util::circle({0,0}, {6,0}, {0,8}).squared_r(), 25);
+    ASSERT_EQ(util::circle({3,4}, 5).squared_r(), 25);
+}
+
+TEST(circle, circumcenters) 
+{
+    std::vector<double> ax{0, 1, 4.5}, ay{0, 10, 8}, bx{6, 2, 2.8}, by{0, 5, 1}, cx{0, 3, 10}, cy{8, 6, 3.4};
+    std::vector<double> x(3), y(3);
+    util::circumcenters(ax.data(), ay.data(), bx.data(), by.data(), cx.data(), cy.data(), x.data(), y.data(), 3);
+
+    ASSERT_EQ(util::point(x[0], y[0]), util::point(3,4));
+    for (int i = 0; i < 3; ++i) {
+        auto center = util::circle({ax[i], ay[i]}, {bx[i], by[i]}, {cx[i], cy[i]}).center();
+        ASSERT_EQ(util::point(x[i], y[i]), center);
+        ASSERT_EQ(util::circumcenter({ax[i], ay[i]}, {bx[i], by[i]}, {cx[i], cy[i]}), center);
+    }
 }
 
 // test: vertex
@@ -436,19 +565,20 @@ TEST(vertex, comparison)
 TEST(dcel, external_edge) 
 {
     dcel d({{1,2}, {4,5}, {5,6}});
-    d.add(dceltype::edge{1,4,7,8,1});
-    d.add(dceltype::edge{dceltype::point_minus_2,6,9,10,2});
-    d.add(dceltype::edge{dceltype::point_minus_1,5,11,12,3});
-    d.add(dceltype::edge{dceltype::point_minus_2,1,6,5,0});
-    d.add(dceltype::edge{1,3,4,6,0});
-    d.add(dceltype::edge{dceltype::point_minus_1,2,5,4,0});
-
-    d.add(dceltype::edge{2,12,8,1,1});
-    d.add(dceltype::edge{dceltype::point_minus_2,9,1,7,1});
-    d.add(dceltype::edge{2,8,10,2,2});
-    d.add(dceltype::edge{dceltype::point_minus_1,11,2,9,2});
-    d.add(dceltype::edge{2,10,12,3,3});
-    d.add(dceltype::edge{1,7,3,11,3});
+    // twins are 1-2, 3-4, ...
+    d.add(dceltype::edge{1,7,9,1});
+    d.add(dceltype::edge{dceltype::point_minus_2,4,6,0});
+    d.add(dceltype::edge{dceltype::point_minus_2,10,11,2});
+    d.add(dceltype::edge{dceltype::point_minus_1,6,2,0});
+    d.add(dceltype::edge{dceltype::point_minus_1,12,8,3});
+    d.add(dceltype::edge{1,2,4,0});
+
+    d.add(dceltype::edge{2,9,1,1});
+    d.add(dceltype::edge{1,5,12,3});
+    d.add(dceltype::edge{dceltype::point_minus_2,1,7,1});
+    d.add(dceltype::edge{2,11,3,2});
+    d.add(dceltype::edge{dceltype::point_minus_1,3,10,2});
+    d.add(dceltype::edge{2,8,5,3});
 
     for (int i = 0; i < 6; ++i) {
         ASSERT_TRUE(d.edge(i).external());
@@ -462,25 +592,26 @@ TEST(dcel, external_edge)
 TEST(dcel, has_negative_vertex) 
 {
     dcel d({{1,2}, {4,5}, {5,6}});
-    d.add(dceltype::edge{1,4,7,8,1});
-    d.add(dceltype::edge{dceltype::point_minus_2,6,9,10,2});
-    d.add(dceltype::edge{dceltype::point_minus_1,5,11,12,3});
-    d.add(dceltype::edge{dceltype::point_minus_2,1,6,5,0});
-    d.add(dceltype::edge{1,3,4,6,0});
-    d.add(dceltype::edge{dceltype::point_minus_1,2,5,4,0});
-
-    d.add(dceltype::edge{2,12,8,1,1});
-    d.add(dceltype::edge{dceltype::point_minus_2,9,1,7,1});
-    d.add(dceltype::edge{2,8,10,2,2});
-    d.add(dceltype::edge{dceltype::point_minus_1,11,2,9,2});
-    d.add(dceltype::edge{2,10,12,3,3});
-    d.add(dceltype::edge{1,7,3,11,3});
+    // twins are 1-2, 3-4, ...
+    d.add(dceltype::edge{1,7,9,1});
+    d.add(dceltype::edge{dceltype::point_minus_2,4,6,0});
+    d.add(dceltype::edge{dceltype::point_minus_2,10,11,2});
+    d.add(dceltype::edge{dceltype::point_minus_1,6,2,0});
+    d.add(dceltype::edge{dceltype::point_minus_1,12,8,3});
+    d.add(dceltype::edge{1,2,4,0});
+
+    d.add(dceltype::edge{2,9,1,1});
+    d.add(dceltype::edge{1,5,12,3});
+    d.add(dceltype::edge{dceltype::point_minus_2,1,7,1});
+    d.add(dceltype::edge{2,11,3,2});
+    d.add(dceltype::edge{dceltype::point_minus_1,3,10,2});
+    d.add(dceltype::edge{2,8,5,3});
 
     ASSERT_FALSE(d.edge(6).has_negative_vertex());
-    ASSERT_FALSE(d.edge(11).has_negative_vertex());
+    ASSERT_FALSE(d.edge(7).has_negative_vertex());
 
     for (int i = 0; i < d.edge_count(); ++i) {
-        if (i == 6 || i == 11) {
+        if (i == 6 || i == 7) {
             continue;
         }
         ASSERT_TRUE(d.edge(i).has_negative_vertex());
@@ -506,6 +637,83 @@ TEST(dcel, get_highest_vertex_index)
     ASSERT_EQ(d.get_highest_vertex_index(), d.vertices().size()-1);
 }
 
+TEST(dcel, integral) 
+{
+    dcel d({{0,0}, {2,0}, {0,2}, {2,2}});
+    ASSERT_TRUE(d.integral());
+    // the same results as the floating point predicates
+    ASSERT_EQ(d.direction({0,0}, {2,0}, {0,2}), util::direction::positive);
+    ASSERT_EQ(d.direction({0,0}, {0,2}, {2,0}), util::direction::negative);
+    ASSERT_EQ(d.direction({0,0}, {1,1}, {2,2}), util::direction::collinear);
+    ASSERT_TRUE(d.in_circle({1,1}, {0,0}, {2,0}, {0,2}));
+    ASSERT_FALSE(d.in_circle({2,2}, {0,0}, {2,0}, {0,2}));
+
+    d.add(dceltype::vertex{{1,1.5}});
+    ASSERT_FALSE(d.integral());
+    ASSERT_EQ(d.direction({0,0}, {2,0}, {0,2}), util::direction::positive);
+    ASSERT_TRUE(d.in_circle({1,1}, {0,0}, {2,0}, {0,2}));
+}
+
+TEST(dcel, face_and_vertex_edges)
+{
+    delaunay del{random_points(500, 3)};
+    const auto& d = del.triangulation();
+
+    for (int face_id = 1; face_id < d.face_count(); ++face_id) {
+        auto ids = d.triangle_ids(face_id);
+        ASSERT_EQ(std::vector<int>(ids.begin(), ids.end()), d.points_ids(face_id));
+        for (auto edge : d.face_edges(face_id)) {
+            ASSERT_EQ(edge.face(), face_id);
+        }
+    }
+
+    // every edge out of a vertex is visited once
+    int edges = 0;
+    for (int vertex_id = 1; vertex_id <= d.vertex_count(); ++vertex_id) {
+        for (auto edge : d.vertex_edges(vertex_id)) {
+            ASSERT_EQ(edge.origin(), vertex_id);
+            ++edges;
+        }
+    }
+    int real_edges = 0;
+    for (int i = 0; i < d.edge_count(); ++i) {
+        real_edges += d.edge(i).origin() > 0;
+    }
+    ASSERT_EQ(edges, real_edges);
+}
+
+TEST(dcel, face_flags)
+{
+    // cached flags kept by insertions and removals are the same as the computed ones
+    auto points = random_points(300, 4);
+    delaunay del{points};
+    for (int i = 0; i < 40; ++i) {
+        del.remove(2 + 5*i);
+        del.insert({points[2 + 5*i].x(), points[2 + 5*i].y() - 1e-3});
+    }
+
+    dcel d = del.triangulation();
+    d.classify();
+    const auto& cached = del.triangulation();
+    for (int face_id = 0; face_id < d.face_count(); ++face_id) {
+        if (d.face_removed(face_id)) {
+            continue;
+        }
+        ASSERT_EQ(cached.imaginary(face_id), d.imaginary(face_id));
+        ASSERT_EQ(cached.bottom(face_id), d.bottom(face_id));
+        ASSERT_EQ(cached.hull_adjacent(face_id), d.hull_adjacent(face_id));
+    }
+
+#ifndef NDEBUG
+    // flags of a face that was never classified are not read
+    dcel unclassified;
+    unclassified.add(dceltype::face{-1});
+    ASSERT_DEATH(unclassified.imaginary(0), "");
+    unclassified.classify(0);
+    ASSERT_TRUE(unclassified.imaginary(0));
+#endif
+}
+
 TEST(dcel, get_direction) 
 {
     // id:    1      2      3      4      5      6      7      8        9         10      11
@@ -578,6 +786,57 @@ TEST(dcel, get_direction)
     ASSERT_EQ(d.get_direction({3,8}, dceltype::point_minus_1, 2), util::direction::positive);
 }
 
+TEST(dcel, add_direction) 
+{
+    // points on a grid, so there are many collinear and equal points
+    std::vector<util::point> points;
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            points.emplace_back(i*0.1, j*0.1);
+        }
+    }
+    dcel d(points);
+
+    std::mt19937 generator(12);
+    std::uniform_int_distribution<int> id_distribution(-2, points.size());
+    auto random_id = [&]() {
+        int id;
+        do { id = id_distribution(generator); } while (id == 0);
+        return id;
+    };
+
+    // batch gives the same negative directions as get_direction, also for symbolic points
+    for (int k = 0; k < 200; ++k) {
+        util::orientation_batch batch;
+        std::vector<std::pair<int,int>> edges;
+        int count = 1 + k % util::orientation_batch::size;
+        while ((int)edges.size() < count) {
+            int source = random_id();
+            int destination = random_id();
+            // the only edge between symbolic points is point_minus_2 - point_minus_1
+            if (source < 0 && destination < 0 && !(source == dceltype::point_minus_2 && destination == dceltype::point_minus_1)) {
+                continue;
+            }
+            edges.emplace_back(source, destination);
+            d.add_direction(batch, source, destination);
+        }
+
+        auto p = points[k % points.size()];
+        unsigned negative = util::negative_directions(p, batch);
+        for (int i = 0; i < count; ++i) {
+            bool expected = d.get_direction(p, edges[i].first, edges[i].second) == util::direction::negative;
+            ASSERT_EQ(((negative >> i) & 1u) != 0, expected);
+        }
+        ASSERT_EQ(negative >> count, 0u);
+    }
+
+    // edge 2 - 3 is an edge of the skipped triangle, edge 3 - 2 is not
+    util::orientation_batch batch;
+    ASSERT_EQ(d.add_directions(batch, {1, 2, 3}, {4, 2, 3}), 3u);
+    ASSERT_EQ(d.add_directions(batch, {2, 1, 3}, {4, 2, 3}), 7u << 2);
+    ASSERT_EQ(batch.count, 5);
+}
+
 // test: graph
 TEST(graph, creation_and_face_map_check) 
 {
@@ -712,14 +971,17 @@ TEST(delaunay, triangulation4)
     ASSERT_TRUE(edges[5] == util::line_segment(util::point(0,1.1),util::point(0,0)));
 }
 
+// edges of these tests depend on the rounding of the coordinates to doubles
+#ifndef SINGLE_PRECISION
 TEST(delaunay, triangulation5) 
 {
     delaunay del = {{{9, 1}, {2, 1.9}, {2, 0}, {0, 1.54}, {2,3.4}, {0.2,1.6}, {1.2,2.6}, {24, 12}}};
     auto edges = del.get_edges();
+    // (0.2,1.6), (1.2,2.6) and (2,3.4) are not exactly collinear in doubles
     ASSERT_TRUE(edges.size() == 27);
-    ASSERT_TRUE(edges[0] == util::line_segment(util::point(2,1.9),util::point(1.2,2.6)));
-    ASSERT_TRUE(edges[1] == util::line_segment(util::point(1.2,2.6),util::point(0.2,1.6)));
-    ASSERT_TRUE(edges[2] == util::line_segment(util::point(0.2,1.6),util::point(2,1.9)));
+    ASSERT_TRUE(edges[0] == util::line_segment(util::point(1.2,2.6),util::point(2,1.9)));
+    ASSERT_TRUE(edges[1] == util::line_segment(util::point(2,1.9),util::point(2,3.4)));
+    ASSERT_TRUE(edges[2] == util::line_segment(util::point(2,3.4),util::point(1.2,2.6)));
     ASSERT_TRUE(edges[3] == util::line_segment(util::point(9,1),util::point(2,3.4)));
     ASSERT_TRUE(edges[4] == util::line_segment(util::point(2,3.4),util::point(2,1.9)));
     ASSERT_TRUE(edges[5] == util::line_segment(util::point(2,1.9),util::point(9,1)));
@@ -732,28 +994,29 @@ TEST(delaunay, triangulation5)
     ASSERT_TRUE(edges[12] == util::line_segment(util::point(0.2,1.6),util::point(2,0)));
     ASSERT_TRUE(edges[13] == util::line_segment(util::point(2,0),util::point(2,1.9)));
     ASSERT_TRUE(edges[14] == util::line_segment(util::point(2,1.9),util::point(0.2,1.6)));
-    ASSERT_TRUE(edges[15] == util::line_segment(util::point(1.2,2.6),util::point(0,1.54)));
-    ASSERT_TRUE(edges[16] == util::line_segment(util::point(0,1.54),util::point(0.2,1.6)));
-    ASSERT_TRUE(edges[17] == util::line_segment(util::point(0.2,1.6),util::point(1.2,2.6)));
+    ASSERT_TRUE(edges[15] == util::line_segment(util::point(2,1.9),util::point(1.2,2.6)));
+    ASSERT_TRUE(edges[16] == util::line_segment(util::point(1.2,2.6),util::point(0.2,1.6)));
+    ASSERT_TRUE(edges[17] == util::line_segment(util::point(0.2,1.6),util::point(2,1.9)));
     ASSERT_TRUE(edges[18] == util::line_segment(util::point(2,0),util::point(0.2,1.6)));
     ASSERT_TRUE(edges[19] == util::line_segment(util::point(0.2,1.6),util::point(0,1.54)));
     ASSERT_TRUE(edges[20] == util::line_segment(util::point(0,1.54),util::point(2,0)));
-    ASSERT_TRUE(edges[21] == util::line_segment(util::point(1.2,2.6),util::point(2,1.9)));
-    ASSERT_TRUE(edges[22] == util::line_segment(util::point(2,1.9),util::point(2,3.4)));
-    ASSERT_TRUE(edges[23] == util::line_segment(util::point(2,3.4),util::point(1.2,2.6)));
-    ASSERT_TRUE(edges[24] == util::line_segment(util::point(0,1.54),util::point(1.2,2.6)));
-    ASSERT_TRUE(edges[25] == util::line_segment(util::point(1.2,2.6),util::point(2,3.4)));
-    ASSERT_TRUE(edges[26] == util::line_segment(util::point(2,3.4),util::point(0,1.54)));
+    ASSERT_TRUE(edges[21] == util::line_segment(util::point(1.2,2.6),util::point(2,3.4)));
+    ASSERT_TRUE(edges[22] == util::line_segment(util::point(2,3.4),util::point(0,1.54)));
+    ASSERT_TRUE(edges[23] == util::line_segment(util::point(0,1.54),util::point(1.2,2.6)));
+    ASSERT_TRUE(edges[24] == util::line_segment(util::point(1.2,2.6),util::point(0,1.54)));
+    ASSERT_TRUE(edges[25] == util::line_segment(util::point(0,1.54),util::point(0.2,1.6)));
+    ASSERT_TRUE(edges[26] == util::line_segment(util::point(0.2,1.6),util::point(1.2,2.6)));
 }
 
 TEST(delaunay, triangulation6) 
 {
     delaunay del = {{{9, 1}, {2, 1.9}, {2, 0}, {5,5}, {1.2,4.9}, {2,3.4}, {0.2,1.6}, {1.2,2.6}, {24, 12}}};
     auto edges = del.get_edges();
+    // (0.2,1.6), (1.2,2.6) and (2,3.4) are not exactly collinear in doubles
     ASSERT_TRUE(edges.size() == 33);
-    ASSERT_TRUE(edges[0] == util::line_segment(util::point(2,1.9),util::point(1.2,2.6)));
-    ASSERT_TRUE(edges[1] == util::line_segment(util::point(1.2,2.6),util::point(0.2,1.6)));
-    ASSERT_TRUE(edges[2] == util::line_segment(util::point(0.2,1.6),util::point(2,1.9)));
+    ASSERT_TRUE(edges[0] == util::line_segment(util::point(1.2,2.6),util::point(2,1.9)));
+    ASSERT_TRUE(edges[1] == util::line_segment(util::point(2,1.9),util::point(2,3.4)));
+    ASSERT_TRUE(edges[2] == util::line_segment(util::point(2,3.4),util::point(1.2,2.6)));
     ASSERT_TRUE(edges[3] == util::line_segment(util::point(2,1.9),util::point(9,1)));
     ASSERT_TRUE(edges[4] == util::line_segment(util::point(9,1),util::point(5,5)));
     ASSERT_TRUE(edges[5] == util::line_segment(util::point(5,5),util::point(2,1.9)));
@@ -769,21 +1032,373 @@ TEST(delaunay, triangulation6)
     ASSERT_TRUE(edges[15] == util::line_segment(util::point(2,1.9),util::point(0.2,1.6)));
     ASSERT_TRUE(edges[16] == util::line_segment(util::point(0.2,1.6),util::point(2,0)));
     ASSERT_TRUE(edges[17] == util::line_segment(util::point(2,0),util::point(2,1.9)));
-    ASSERT_TRUE(edges[18] == util::line_segment(util::point(1.2,2.6),util::point(1.2,4.9)));
-    ASSERT_TRUE(edges[19] == util::line_segment(util::point(1.2,4.9),util::point(0.2,1.6)));
-    ASSERT_TRUE(edges[20] == util::line_segment(util::point(0.2,1.6),util::point(1.2,2.6)));
+    ASSERT_TRUE(edges[18] == util::line_segment(util::point(2,1.9),util::point(1.2,2.6)));
+    ASSERT_TRUE(edges[19] == util::line_segment(util::point(1.2,2.6),util::point(0.2,1.6)));
+    ASSERT_TRUE(edges[20] == util::line_segment(util::point(0.2,1.6),util::point(2,1.9)));
     ASSERT_TRUE(edges[21] == util::line_segment(util::point(2,3.4),util::point(2,1.9)));
     ASSERT_TRUE(edges[22] == util::line_segment(util::point(2,1.9),util::point(5,5)));
     ASSERT_TRUE(edges[23] == util::line_segment(util::point(5,5),util::point(2,3.4)));
     ASSERT_TRUE(edges[24] == util::line_segment(util::point(2,3.4),util::point(5,5)));
     ASSERT_TRUE(edges[25] == util::line_segment(util::point(5,5),util::point(1.2,4.9)));
     ASSERT_TRUE(edges[26] == util::line_segment(util::point(1.2,4.9),util::point(2,3.4)));
-    ASSERT_TRUE(edges[27] == util::line_segment(util::point(1.2,2.6),util::point(2,1.9)));
-    ASSERT_TRUE(edges[28] == util::line_segment(util::point(2,1.9),util::point(2,3.4)));
-    ASSERT_TRUE(edges[29] == util::line_segment(util::point(2,3.4),util::point(1.2,2.6)));
-    ASSERT_TRUE(edges[30] == util::line_segment(util::point(1.2,4.9),util::point(1.2,2.6)));
-    ASSERT_TRUE(edges[31] == util::line_segment(util::point(1.2,2.6),util::point(2,3.4)));
-    ASSERT_TRUE(edges[32] == util::line_segment(util::point(2,3.4),util::point(1.2,4.9)));
+    ASSERT_TRUE(edges[27] == util::line_segment(util::point(1.2,2.6),util::point(2,3.4)));
+    ASSERT_TRUE(edges[28] == util::line_segment(util::point(2,3.4),util::point(1.2,4.9)));
+    ASSERT_TRUE(edges[29] == util::line_segment(util::point(1.2,4.9),util::point(1.2,2.6)));
+    ASSERT_TRUE(edges[30] == util::line_segment(util::point(1.2,2.6),util::point(1.2,4.9)));
+    ASSERT_TRUE(edges[31] == util::line_segment(util::point(1.2,4.9),util::point(0.2,1.6)));
+    ASSERT_TRUE(edges[32] == util::line_segment(util::point(0.2,1.6),util::point(1.2,2.6)));
+}
+#endif
+
+TEST(delaunay, brio_order) 
+{
+    // triangulation doesn't depend on the insertion order
+    // if there are no four cocircular points
+    auto check_same_triangulation = [](const std::vector<util::point>& points) {
+        delaunay del{points};
+        delaunay del_brio{points, {delaunaytype::insertion_order::brio}};
+        ASSERT_TRUE(same_edges(del.get_edges(), del_brio.get_edges()));
+    };
+
+    check_same_triangulation({{9, 1}, {2, 1.9}, {2, 0}, {0, 1.54}, {2,3.4}, {0.2,1.6}, {1.2,2.6}, {24, 12}});
+    check_same_triangulation({{9, 1}, {2, 1.9}, {2, 0}, {5,5}, {1.2,4.9}, {2,3.4}, {0.2,1.6}, {1.2,2.6}, {24, 12}});
+    check_same_triangulation(random_points(500, 1));
+}
+
+TEST(delaunay, walk_location) 
+{
+    // walk finds the same triangles as the history graph
+    auto check_same_triangulation = [](const std::vector<util::point>& points, delaunaytype::insertion_order order) {
+        delaunay del{points, {order}};
+        delaunay del_walk{points, {order, delaunaytype::point_location::walk}};
+        delaunay del_batched{points, {order, delaunaytype::point_location::batched_history_dag}};
+        ASSERT_TRUE(same_edges(del.get_edges(), del_walk.get_edges()));
+        ASSERT_TRUE(same_edges(del.get_edges(), del_batched.get_edges()));
+    };
+
+    check_same_triangulation({{0, 0}, {0, 1.1}, {1, 0}, {1, 1}, {2,3.4}, {0.2,1.6}}, delaunaytype::insertion_order::input);
+    check_same_triangulation({{9, 1}, {2, 1.9}, {2, 0}, {5,5}, {1.2,4.9}, {2,3.4}, {0.2,1.6}, {1.2,2.6}, {24, 12}}, delaunaytype::insertion_order::input);
+    check_same_triangulation(random_points(500, 3), delaunaytype::insertion_order::input);
+    check_same_triangulation(random_points(500, 3), delaunaytype::insertion_order::brio);
+
+    // points on the triangle edges
+    check_same_triangulation({{0, 0}, {2, 0}, {1, 2}, {1, 0}, {0.5, 1}, {1, 0.5}}, delaunaytype::insertion_order::input);
+}
+
+TEST(delaunay, flip_statistics) 
+{
+    auto points = random_points(1000, 7);
+    delaunay del{points};
+    auto& statistics = del.statistics();
+
+    // the highest point is in the initial triangle
+    ASSERT_EQ(statistics.insertions, (int)points.size() - 1);
+    ASSERT_GT(statistics.flips, 0);
+    ASSERT_GE(statistics.max_insertion_flips, statistics.last_insertion_flips);
+    ASSERT_LE(statistics.max_insertion_flips, statistics.flips);
+
+    // the last point is below the hull, but inside the circle of the first three points,
+    // so the edge between the lower points gets flipped
+    delaunay del_flip{{{0, 2}, {-1, 0}, {1, 0}, {0, -0.4}}};
+    ASSERT_EQ(del_flip.statistics().insertions, 3);
+    ASSERT_GT(del_flip.statistics().last_insertion_flips, 0);
+}
+
+TEST(delaunay, insert) 
+{
+    // the highest point is in the initial points, so the other points can be inserted
+    auto points = random_points(300, 8);
+    points.emplace_back(50, 150);
+
+    // the first points are outside the convex hull, so they change it
+    std::vector<util::point> inserted{{-20, 50}, {120, -10}};
+    auto inside_points = random_points(100, 9);
+    inserted.insert(inserted.end(), inside_points.begin(), inside_points.end());
+
+    auto all_points = points;
+    all_points.insert(all_points.end(), inserted.begin(), inserted.end());
+    delaunay expected{all_points};
+    voronoi expected_vor{expected.triangulation()};
+    largest_empty_circle expected_lec(expected.triangulation(), expected_vor.graph());
+
+    auto check_insert = [&](delaunaytype::options options) {
+        delaunay del{points, options};
+        voronoi vor{del.triangulation()};
+        largest_empty_circle lec(del.triangulation(), vor.graph());
+
+        for (auto point : inserted) {
+            auto changes = del.insert(point);
+            ASSERT_EQ(changes.vertex_id, del.triangulation().vertex_count());
+            ASSERT_GE(changes.created_faces.size(), 3u);
+            ASSERT_TRUE(std::includes(changes.created_faces.begin(), changes.created_faces.end(), 
+                        changes.destroyed_faces.begin(), changes.destroyed_faces.end()));
+
+            lec.update(del.triangulation(), vor.graph(), vor.update(changes));
+        }
+
+        ASSERT_TRUE(same_edges(del.get_edges(), expected.get_edges()));
+        ASSERT_EQ(vor.get_edges().size(), expected_vor.get_edges().size());
+        ASSERT_EQ(lec.candidates().size(), expected_lec.candidates().size());
+        // radii are rounded to util::coordinate
+        double r = expected_lec.get_largest_circle().r();
+        ASSERT_NEAR(lec.get_largest_circle().r(), r, 4*std::numeric_limits<util::coordinate>::epsilon()*r);
+
+        // point above the highest point and the same point
+        ASSERT_THROW(del.insert({0, 200}), std::invalid_argument);
+        ASSERT_THROW(del.insert(inserted.back()), std::invalid_argument);
+    };
+
+    check_insert({});
+    check_insert({delaunaytype::insertion_order::brio, delaunaytype::point_location::walk});
+
+    delaunaytype::options options;
+    options.engine = delaunaytype::engine::divide_and_conquer;
+    check_insert(options);
+}
+
+TEST(delaunay, remove) 
+{
+    auto points = random_points(200, 10);
+    points.emplace_back(50, 150);
+
+    delaunay del{points};
+    voronoi vor{del.triangulation()};
+    largest_empty_circle lec(del.triangulation(), vor.graph());
+    int edge_count = del.triangulation().edge_count();
+
+    // vertex 1 is the highest point, so the others can be removed
+    std::vector<util::point> remaining;
+    for (int vertex_id = 1; vertex_id <= del.triangulation().vertex_count(); ++vertex_id) {
+        auto point = del.triangulation().vertex(vertex_id-1).point();
+        if (vertex_id % 3 != 0) {
+            remaining.push_back(point);
+            continue;
+        }
+
+        auto changes = del.remove(vertex_id);
+        ASSERT_EQ(changes.vertex_id, vertex_id);
+        ASSERT_FALSE(changes.destroyed_faces.empty());
+        lec.update(del.triangulation(), vor.graph(), vor.update(changes));
+    }
+
+    delaunay expected{remaining};
+    voronoi expected_vor{expected.triangulation()};
+    largest_empty_circle expected_lec(expected.triangulation(), expected_vor.graph());
+
+    ASSERT_TRUE(same_edges(del.get_edges(), expected.get_edges()));
+    ASSERT_EQ(vor.get_edges().size(), expected_vor.get_edges().size());
+    ASSERT_EQ(lec.candidates().size(), expected_lec.candidates().size());
+    ASSERT_NEAR(lec.get_largest_circle().r(), expected_lec.get_largest_circle().r(), 1e-9);
+
+    // highest, removed and invalid vertices
+    ASSERT_THROW(del.remove(1), std::invalid_argument);
+    ASSERT_THROW(del.remove(3), std::invalid_argument);
+    ASSERT_THROW(del.remove(0), std::invalid_argument);
+
+    // inserted points reuse the removed edges and faces
+    for (auto point : random_points(20, 11)) {
+        auto changes = del.insert(point);
+        lec.update(del.triangulation(), vor.graph(), vor.update(changes));
+    }
+    ASSERT_LE(del.triangulation().edge_count(), edge_count);
+
+    voronoi final_vor{del.triangulation()};
+    largest_empty_circle final_lec(del.triangulation(), final_vor.graph());
+    ASSERT_EQ(vor.get_edges().size(), final_vor.get_edges().size());
+    ASSERT_EQ(lec.candidates().size(), final_lec.candidates().size());
+}
+
+TEST(delaunay, move) 
+{
+    auto points = random_points(500, 16);
+    points.emplace_back(50, 150);
+    delaunay del{points};
+
+    // small moves are repaired by flips, larger ones invert triangles
+    std::mt19937 generator(17);
+    for (double jitter : {0.01, 0.5}) {
+        std::uniform_real_distribution<double> distribution(-jitter, jitter);
+        std::vector<util::point> moved;
+        for (const auto& v : del.triangulation().vertices()) {
+            moved.emplace_back(v.point().x() + distribution(generator), v.point().y() + distribution(generator));
+        }
+        ASSERT_TRUE(del.move(moved));
+        ASSERT_TRUE(same_edges(del.get_edges(), delaunay{moved}.get_edges()));
+    }
+
+    // highest vertex has to stay the highest
+    auto edges = del.get_edges();
+    std::vector<util::point> moved;
+    for (const auto& v : del.triangulation().vertices()) {
+        moved.push_back(v.point());
+    }
+    moved[1] = {50, 200};
+    ASSERT_FALSE(del.move(moved));
+    ASSERT_TRUE(same_edges(del.get_edges(), edges));
+
+    // duplicate points are found before any vertex is moved
+    moved[1] = moved[2];
+    moved[3] = {moved[3].x() + 0.5, moved[3].y()};
+    ASSERT_THROW(del.move(moved), std::invalid_argument);
+    ASSERT_TRUE(same_edges(del.get_edges(), edges));
+    moved[1] = del.triangulation().vertex(1).point();
+    ASSERT_TRUE(del.move(moved));
+    ASSERT_TRUE(same_edges(del.get_edges(), delaunay{moved}.get_edges()));
+    // points are a permutation of the current points, so a vertex can move to the old
+    // point of another vertex whose triangles are inverted too
+    for (int n : {30, 500}) {
+        delaunay permuted{random_points(n, 21)};
+        const auto& d = permuted.triangulation();
+        std::vector<util::point> targets{d.vertex(0).point()};
+        for (int i = 1; i < d.vertex_count(); ++i) {
+            targets.push_back(d.vertex(i % (d.vertex_count()-1) + 1).point());
+        }
+        ASSERT_TRUE(permuted.move(targets));
+        ASSERT_TRUE(same_edges(permuted.get_edges(), delaunay{targets}.get_edges()));
+        for (int i = 0; i < d.vertex_count(); ++i) {
+            ASSERT_EQ(d.vertex(i).point(), targets[i]);
+        }
+    }
+}
+
+TEST(delaunay, divide_and_conquer) 
+{
+    auto check_same_triangulation = [](const std::vector<util::point>& points) {
+        delaunay del{points};
+        delaunaytype::options options;
+        options.engine = delaunaytype::engine::divide_and_conquer;
+        delaunay del_dc{points, options};
+        ASSERT_TRUE(same_edges(del.get_edges(), del_dc.get_edges()));
+
+        // voronoi diagram and the largest empty circle are built on the same layout
+        voronoi vor{del.triangulation()};
+        voronoi vor_dc{del_dc.triangulation()};
+        ASSERT_EQ(vor.get_edges().size(), vor_dc.get_edges().size());
+        ASSERT_TRUE(same_edges(convex_hull(del.triangulation()).edges(), convex_hull(del_dc.triangulation()).edges()));
+
+        largest_empty_circle lec(del.triangulation(), vor.graph());
+        largest_empty_circle lec_dc(del_dc.triangulation(), vor_dc.graph());
+        ASSERT_EQ(lec.get_largest_circle(), lec_dc.get_largest_circle());
+    };
+
+    check_same_triangulation({{0, 0}, {0, 1.1}, {1, 0}, {1, 1}});
+    check_same_triangulation({{0, 0}, {0, 1.1}, {1, 0}, {1, 1}, {2,3.4}, {0.2,1.6}});
+    check_same_triangulation({{9, 1}, {2, 1.9}, {2, 0}, {0, 1.54}, {2,3.4}, {0.2,1.6}, {1.2,2.6}, {24, 12}});
+    check_same_triangulation({{9, 1}, {2, 1.9}, {2, 0}, {5,5}, {1.2,4.9}, {2,3.4}, {0.2,1.6}, {1.2,2.6}, {24, 12}});
+    check_same_triangulation({{15,6},{0,3},{17,6},{4,0},{18,5},{9,17},{4,7},{4,12},{10,4},{16,13}});
+    check_same_triangulation(random_points(1000, 4));
+
+    // triangle
+    delaunaytype::options options;
+    options.engine = delaunaytype::engine::divide_and_conquer;
+    delaunay del_dc{{{0, 0}, {0, 1}, {1, 0}}, options};
+    ASSERT_EQ(del_dc.get_edges().size(), 3);
+}
+
+TEST(delaunay, parallel_divide_and_conquer) 
+{
+    // parallel construction gives exactly the same dcel as the sequential one
+    auto check_same_dcel = [](const std::vector<util::point>& points, int threads) {
+        delaunaytype::options options;
+        options.engine = delaunaytype::engine::divide_and_conquer;
+        delaunay del{points, options};
+        options.threads = threads;
+        delaunay del_parallel{points, options};
+
+        const auto& d = del.triangulation();
+        const auto& d_parallel = del_parallel.triangulation();
+        ASSERT_EQ(d.edge_count(), d_parallel.edge_count());
+        ASSERT_EQ(d.face_count(), d_parallel.face_count());
+        for (int i = 0; i < d.edge_count(); ++i) {
+            ASSERT_EQ(d.edge(i).origin(), d_parallel.edge(i).origin());
+            ASSERT_EQ(d.edge(i).twin(), d_parallel.edge(i).twin());
+            ASSERT_EQ(d.edge(i).next(), d_parallel.edge(i).next());
+            ASSERT_EQ(d.edge(i).face(), d_parallel.edge(i).face());
+        }
+    };
+
+    check_same_dcel(random_points(3000, 5), 2);
+    check_same_dcel(random_points(3000, 5), 3);
+    check_same_dcel(random_points(5000, 6), 8);
+}
+
+// triangle mesh
+TEST(triangle_mesh, neighbours)
+{
+    delaunay del{random_points(2000, 7)};
+    del.remove(10);
+    auto mesh = del.mesh();
+
+    ASSERT_EQ(mesh.get_edges(), del.get_edges());
+    for (int t = 0; t < mesh.triangle_count(); ++t) {
+        for (int i = 0; i < 3; ++i) {
+            // neighbour shares the edge opposite to vertex i in the other direction
+            int n = mesh.neighbours(t)[i];
+            if (n == -1) {
+                continue;
+            }
+            int a = mesh.vertices(t)[(i+1)%3];
+            int b = mesh.vertices(t)[(i+2)%3];
+            int j = mesh.index(n, b);
+            ASSERT_NE(j, -1);
+            ASSERT_EQ(mesh.vertices(n)[(j+1)%3], a);
+            ASSERT_EQ(mesh.neighbours(n)[(j+2)%3], t);
+        }
+    }
+
+    // neighbours found from the triangles are the same
+    std::vector<std::array<int,3>> triangles;
+    for (int t = 0; t < mesh.triangle_count(); ++t) {
+        triangles.push_back(mesh.vertices(t));
+    }
+    triangle_mesh mesh2{mesh.points(), triangles};
+    for (int t = 0; t < mesh.triangle_count(); ++t) {
+        ASSERT_EQ(mesh.neighbours(t), mesh2.neighbours(t));
+    }
+}
+
+TEST(triangle_mesh, adapters)
+{
+    // voronoi graph and the largest empty circle are the same as the ones built from dcel
+    delaunay del{random_points(2000, 8)};
+    auto mesh = del.mesh();
+    voronoi vor{del.triangulation()};
+    voronoi vor_mesh{mesh};
+
+    ASSERT_TRUE(same_edges(vor.get_edges(), vor_mesh.get_edges()));
+
+    largest_empty_circle lec(del.triangulation(), vor.graph());
+    // triangulation converted from the mesh is shared with the voronoi graph
+    largest_empty_circle lec_mesh(vor_mesh.triangulation(), vor_mesh.graph());
+    ASSERT_EQ(lec.get_largest_circle(), lec_mesh.get_largest_circle());
+    ASSERT_EQ(lec.candidates().size(), lec_mesh.candidates().size());
+
+    // moved graph keeps its triangulation
+    voronoi moved{std::move(vor_mesh)};
+    ASSERT_TRUE(same_edges(vor.get_edges(), moved.get_edges()));
+    ASSERT_EQ(moved.triangulation().face_count(), del.triangulation().face_count());
+    static_assert(!std::is_copy_constructible<voronoi>::value, "graph built from a mesh owns its triangulation");
+}
+
+// spatial sort
+TEST(spatial_sort, brio_order) 
+{
+    auto points = random_points(1000, 2);
+    auto order = util::brio_order(points, 1);
+
+    // all indices except the first one are in the order exactly once
+    ASSERT_EQ(order.size(), points.size()-1);
+    std::sort(order.begin(), order.end());
+    std::vector<int> expected(points.size()-1);
+    std::iota(expected.begin(), expected.end(), 1);
+    ASSERT_EQ(order, expected);
+}
+
+TEST(spatial_sort, hilbert_order) 
+{
+    // points on a 2x2 grid are visited as the first order hilbert curve
+    std::vector<util::point> points{{1,1}, {0,0}, {1,0}, {0,1}};
+    ASSERT_EQ(util::hilbert_order(points), std::vector<int>({1, 3, 0, 2}));
 }
 
 // convex hull
@@ -946,6 +1561,369 @@ TEST(voronoi, edge_count8)
     ASSERT_EQ(voronoi_edges.size(), 50);
 }
 
+TEST(voronoi, threads) 
+{
+    // graph is the same for any number of threads
+    auto check = [](const dcel& triangulation) {
+        voronoi vor{triangulation};
+        voronoi vor_threads{triangulation, 3};
+        const auto& g = vor.graph();
+        const auto& g_threads = vor_threads.graph();
+
+        ASSERT_EQ(g.vertex_count(), g_threads.vertex_count());
+        for (int i = 0; i < g.vertex_count(); ++i) {
+            ASSERT_EQ(g.vertex(i).x(), g_threads.vertex(i).x());
+            ASSERT_EQ(g.vertex(i).y(), g_threads.vertex(i).y());
+            ASSERT_EQ(g.vertex(i).incident_edge(), g_threads.vertex(i).incident_edge());
+        }
+        ASSERT_EQ(g.edge_count(), g_threads.edge_count());
+        for (int i = 0; i < g.edge_count(); ++i) {
+            ASSERT_EQ(g.edge(i).origin(), g_threads.edge(i).origin());
+            ASSERT_EQ(g.edge(i).previous(), g_threads.edge(i).previous());
+            ASSERT_EQ(g.edge(i).next(), g_threads.edge(i).next());
+            ASSERT_EQ(g.edge(i).face(), g_threads.edge(i).face());
+        }
+        ASSERT_EQ(g.face_count(), g_threads.face_count());
+        for (int i = 0; i < g.face_count(); ++i) {
+            ASSERT_EQ(g.face(i).edge(), g_threads.face(i).edge());
+        }
+        for (int i = 1; i <= triangulation.edge_count(); ++i) {
+            ASSERT_EQ(vor.dual_edge(i), vor_threads.dual_edge(i));
+        }
+    };
+
+    delaunay del{random_points(20000, 5)};
+    check(del.triangulation());
+
+    // faces of removed vertices are skipped
+    for (int vertex_id = 100; vertex_id < 200; vertex_id += 7) {
+        del.remove(vertex_id);
+    }
+    check(del.triangulation());
+}
+
+TEST(voronoi, dual_edges)
+{
+    // dual edge goes from the vertex of the twin's face to the vertex of the edge's face
+    // and it is in the face of the origin
+    auto check = [](const dcel& d, const voronoi& vor) {
+        for (int i = 0; i < d.edge_count(); ++i) {
+            auto edge = d.edge(i);
+            if (d.edge_removed(i) || edge.origin() < 0 || (edge | edgerelation::twin).origin() < 0) {
+                continue;
+            }
+            int dual_id = vor.dual_edge(edge.id());
+            ASSERT_GT(dual_id, 0);
+            auto dual = vor.graph().edge(dual_id-1);
+            ASSERT_EQ(dual.origin(), (edge | edgerelation::twin).face());
+            ASSERT_EQ((dual | edgerelation::twin).origin(), edge.face());
+            ASSERT_EQ(dual.face(), edge.origin());
+            ASSERT_EQ(vor.dual_edge(edge.twin()), dual.twin());
+        }
+    };
+
+    delaunay del{random_points(2000, 11)};
+    voronoi vor{del.triangulation()};
+    check(del.triangulation(), vor);
+
+    // mapping is kept by updates
+    vor.update(del.insert({50.5, 49.5}));
+    check(del.triangulation(), vor);
+    vor.update(del.remove(17));
+    check(del.triangulation(), vor);
+}
+
+// compact voronoi
+TEST(compact_voronoi, cells)
+{
+    auto points = random_points(5000, 20);
+    points.emplace_back(50, 150);
+    delaunay del{points};
+    for (int vertex_id = 2; vertex_id <= 500; vertex_id += 7) {
+        del.remove(vertex_id);
+    }
+
+    // cells have the vertices of the faces of the graph in the same order
+    voronoi vor{del.triangulation()};
+    const auto& graph = vor.graph();
+    for (int threads : {1, 3}) {
+        compact_voronoi compact{del.triangulation(), threads};
+        const auto& offsets = compact.offsets();
+        ASSERT_EQ((int)offsets.size(), del.triangulation().vertex_count()+1);
+
+        int edge_count = 0;
+        for (int i = 0; i < graph.edge_count(); ++i) {
+            edge_count += !graph.edge_removed(i);
+        }
+        ASSERT_EQ((int)compact.indices().size(), edge_count);
+
+        for (int vertex_id = 1; vertex_id <= del.triangulation().vertex_count(); ++vertex_id) {
+            std::vector<util::point> cell;
+            if (!del.triangulation().vertex_removed(vertex_id-1)) {
+                for (auto edge : graph.face_edges(vertex_id)) {
+                    cell.push_back(edge.point());
+                }
+            }
+            ASSERT_EQ(offsets[vertex_id] - offsets[vertex_id-1], (int)cell.size());
+            ASSERT_EQ(compact.cell(vertex_id), cell);
+        }
+    }
+}
+
+// clipped voronoi
+// returns sum of the areas of the cells, edges of a cell are linked
+double cells_area(const dcel& graph)
+{
+    double area = 0;
+    for (int face_id = 1; face_id < graph.face_count(); ++face_id) {
+        if (graph.face_removed(face_id)) {
+            continue;
+        }
+        for (auto edge : graph.face_edges(face_id)) {
+            auto next = edge | edgerelation::next;
+            EXPECT_EQ(next.origin(), (edge | edgerelation::twin).origin());
+            EXPECT_EQ(next.previous(), edge.id());
+            EXPECT_EQ(next.face(), face_id);
+            area += edge.point().x()*next.point().y() - next.point().x()*edge.point().y();
+        }
+    }
+    return area/2;
+}
+
+TEST(clipped_voronoi, convex_hull)
+{
+    // cells cover the convex hull, coordinates are far from the vertices at infinity
+    for (double scale : {1.0, 10000.0}) {
+        auto points = random_points(2000, 13);
+        for (auto& p : points) {
+            p = {p.x()*scale, p.y()*scale};
+        }
+        delaunay del{points};
+        voronoi vor{del.triangulation()};
+        clipped_voronoi clipped{del.triangulation(), vor};
+
+        double hull_area = 0;
+        for (const auto& e : convex_hull(del.triangulation()).edges()) {
+            hull_area += e.origin().x()*e.destination().y() - e.destination().x()*e.origin().y();
+        }
+        ASSERT_NEAR(cells_area(clipped.graph()), hull_area/2, 1e-6*hull_area);
+
+        // every cell is clipped, every clip point is on a voronoi edge
+        const auto& graph = clipped.graph();
+        for (int face_id = 1; face_id < graph.face_count(); ++face_id) {
+            ASSERT_FALSE(graph.face_removed(face_id));
+        }
+        for (int vertex_id = vor.graph().vertex_count()+1; vertex_id <= graph.vertex_count(); ++vertex_id) {
+            int edge_id = clipped.crossed_edge(vertex_id);
+            ASSERT_NE(clipped.boundary_edge(vertex_id), -1);
+            if (edge_id != -1) {
+                ASSERT_EQ(graph.edge(edge_id-1).origin(), vertex_id);
+            }
+        }
+    }
+}
+
+TEST(clipped_voronoi, box)
+{
+    delaunay del{random_points(2000, 14)};
+    voronoi vor{del.triangulation()};
+
+    // box cuts the points, contains all of them and is inside one cell
+    ASSERT_NEAR(cells_area(clipped_voronoi(del.triangulation(), vor, {20, 80, 30, 60}).graph()), 60*30, 1e-6*60*30);
+    ASSERT_NEAR(cells_area(clipped_voronoi(del.triangulation(), vor, {-1e6, 1e6, -1e6, 1e6}).graph()), 4e12, 1e-6*4e12);
+    auto p = del.triangulation().vertex(99).point();
+    clipped_voronoi small{del.triangulation(), vor, {p.x(), p.x()+1e-3, p.y(), p.y()+1e-3}};
+    ASSERT_GT(cells_area(small.graph()), 0);
+    for (int face_id = 1; face_id < small.graph().face_count(); ++face_id) {
+        ASSERT_EQ(small.graph().face_removed(face_id), face_id != 100);
+    }
+
+    // box is checked
+    ASSERT_THROW(clipped_voronoi(del.triangulation(), vor, {0, 100, 0}), std::invalid_argument);
+    ASSERT_THROW(clipped_voronoi(del.triangulation(), vor, {100, 0, 0, 100}), std::invalid_argument);
+    ASSERT_THROW(clipped_voronoi(del.triangulation(), vor, {0, 100, 50, 50}), std::invalid_argument);
+}
+
+TEST(clipped_voronoi, largest_empty_circle)
+{
+    // candidates are read from the clipped graph
+    delaunay del{random_points(5000, 15)};
+    voronoi vor{del.triangulation()};
+    largest_empty_circle lec(del.triangulation(), vor.graph());
+    largest_empty_circle clipped_lec(del.triangulation(), vor.graph(), clipped_voronoi{del.triangulation(), vor});
+
+    ASSERT_EQ(clipped_lec.candidates().size(), lec.candidates().size());
+    ASSERT_EQ(clipped_lec.get_largest_circle(), lec.get_largest_circle());
+
+    // centers are in the box, the circle is empty and not smaller than
+    // the empty circles at the points of a grid over the box, corners included
+    auto points = random_points(500, 16);
+    delaunay box_del{points};
+    voronoi box_vor{box_del.triangulation()};
+    for (std::vector<double> box : {std::vector<double>{-50, 150, -50, 150}, std::vector<double>{20, 70, 10, 40}}) {
+        clipped_voronoi clipped{box_del.triangulation(), box_vor, box};
+        auto circle = largest_empty_circle(box_del.triangulation(), box_vor.graph(), clipped).get_largest_circle();
+        auto center = circle.center();
+        ASSERT_TRUE(center.x() >= box[0] - EPS && center.x() <= box[1] + EPS && center.y() >= box[2] - EPS && center.y() <= box[3] + EPS);
+
+        auto nearest = [&](util::point p) {
+            double distance = std::numeric_limits<double>::max();
+            for (auto q : points) {
+                distance = std::min(distance, p.distance(q));
+            }
+            return distance;
+        };
+        ASSERT_NEAR(nearest(center), circle.r(), 1e-6*circle.r());
+        for (int i = 0; i <= 100; ++i) {
+            for (int j = 0; j <= 100; ++j) {
+                util::point p{box[0] + (box[1]-box[0])*i/100, box[2] + (box[3]-box[2])*j/100};
+                ASSERT_LE(nearest(p), circle.r()*(1 + 1e-6));
+            }
+        }
+    }
+}
+
+// lloyd
+TEST(lloyd, convergence)
+{
+    lloydtype::options options;
+    options.threshold = 1e-3;
+    options.max_iterations = 1000;
+    lloyd relaxation{random_points(100, 18), {0, 100, 0, 100}, options};
+
+    ASSERT_LT(relaxation.iterations(), options.max_iterations);
+    ASSERT_LE(relaxation.last_move(), options.threshold);
+    ASSERT_LT(relaxation.rebuilds(), relaxation.iterations());
+
+    // triangulation was repaired, points are in the box
+    auto points = relaxation.points();
+    ASSERT_TRUE(same_edges(relaxation.triangulation().get_edges(), delaunay{points}.get_edges()));
+    for (auto p : points) {
+        ASSERT_TRUE(p.x() >= 0 && p.x() <= 100 && p.y() >= 0 && p.y() <= 100);
+    }
+}
+
+TEST(lloyd, threads)
+{
+    lloydtype::options options;
+    options.max_iterations = 3;
+    auto points = random_points(9000, 19);
+    lloyd relaxation{points, {0, 100, 0, 100}, options};
+    options.threads = 3;
+    lloyd parallel_relaxation{points, {0, 100, 0, 100}, options};
+
+    ASSERT_EQ(relaxation.iterations(), 3);
+    ASSERT_EQ(parallel_relaxation.points(), relaxation.points());
+}
+
+// snapshot
+TEST(snapshot, write_and_map)
+{
+    delaunay del{random_points(3000, 9)};
+    del.remove(5);
+    voronoi vor{del.triangulation()};
+    const auto& d = del.triangulation();
+
+    std::string path = ::testing::TempDir() + "snapshot.bin";
+    snapshot::write(path, d, vor.graph());
+    snapshot s(path);
+
+    // arrays are used in place
+    const auto& view = s.triangulation();
+    ASSERT_EQ(view.vertex_count(), d.vertex_count());
+    ASSERT_EQ(view.edge_count(), d.edge_count());
+    ASSERT_EQ(view.face_count(), d.face_count());
+    for (int i = 0; i < d.edge_count(); ++i) {
+        ASSERT_EQ(view.origin(i), d.edge(i).origin());
+        ASSERT_EQ(view.twin(i), d.edge(i).twin());
+        ASSERT_EQ(view.next(i), d.edge(i).next());
+        ASSERT_EQ(view.face(i), d.edge(i).face());
+    }
+    for (int i = 0; i < d.face_count(); ++i) {
+        ASSERT_EQ(view.face_edge(i), d.face(i).edge());
+        ASSERT_EQ(view.imaginary(i), d.imaginary(i));
+    }
+    ASSERT_EQ(s.voronoi().vertex_count(), vor.graph().vertex_count());
+
+    // copied dcels give the same largest empty circle
+    largest_empty_circle lec(d, vor.graph());
+    largest_empty_circle lec_snapshot(s.triangulation().to_dcel(), s.voronoi().to_dcel());
+    ASSERT_EQ(lec.get_largest_circle(), lec_snapshot.get_largest_circle());
+
+    // the copy can be changed
+    auto copy = s.triangulation().to_dcel();
+    auto original = d;
+    ASSERT_EQ(copy.new_edge(), original.new_edge());
+
+    std::remove(path.c_str());
+    ASSERT_THROW(snapshot{path}, std::runtime_error);
+}
+
+TEST(snapshot, invalid_files)
+{
+    delaunay del{random_points(500, 10)};
+    voronoi vor{del.triangulation()};
+    std::string path = ::testing::TempDir() + "snapshot.bin";
+    snapshot::write(path, del.triangulation(), vor.graph());
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    in.close();
+
+    // writes the changed bytes and checks that the loader rejects them
+    auto check_rejected = [&](const std::vector<char>& changed) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(changed.data(), changed.size());
+        out.close();
+        ASSERT_THROW(snapshot{path}, std::runtime_error);
+    };
+    auto set = [&](std::size_t offset, auto value) {
+        auto changed = bytes;
+        std::memcpy(changed.data() + offset, &value, sizeof(value));
+        return changed;
+    };
+    using snapshottype::header;
+    using snapshottype::section;
+
+    // magic, version, byte order and coordinate type
+    auto changed = bytes;
+    changed[0] = 'X';
+    check_rejected(changed);
+    check_rejected(set(offsetof(header, version), snapshottype::version + 1));
+    check_rejected(set(offsetof(header, byte_order), std::uint32_t{0x04030201}));
+    check_rejected(set(offsetof(header, coordinate_size), std::uint32_t{3}));
+
+    // arrays run past the end of the file
+    check_rejected(std::vector<char>(bytes.begin(), bytes.begin() + bytes.size()/2));
+    check_rejected(std::vector<char>(bytes.begin(), bytes.begin() + sizeof(header) - 1));
+    std::size_t voronoi_section = offsetof(header, sections) + sizeof(section);
+    check_rejected(set(voronoi_section + offsetof(section, free_faces), std::uint64_t(bytes.size()) / 64 * 64 + 64));
+    check_rejected(set(voronoi_section + offsetof(section, edge_count), std::uint32_t{1u << 30}));
+    // misaligned array
+    check_rejected(set(offsetof(header, sections) + offsetof(section, y), std::uint64_t{68}));
+
+    // ids outside the arrays
+    section triangulation_section;
+    section voronoi;
+    std::memcpy(&triangulation_section, bytes.data() + offsetof(header, sections), sizeof(section));
+    std::memcpy(&voronoi, bytes.data() + voronoi_section, sizeof(section));
+    check_rejected(set(voronoi.edge_next, int(voronoi.edge_count) + 5));
+    check_rejected(set(voronoi.edge_next + sizeof(int), 0));
+    check_rejected(set(voronoi.edge_faces, int(voronoi.face_count)));
+    check_rejected(set(voronoi.incident_edges, -2));
+    check_rejected(set(voronoi.face_edges + sizeof(int), int(voronoi.edge_count) + 1));
+    check_rejected(set(triangulation_section.edge_origins, int(triangulation_section.vertex_count) + 1));
+    check_rejected(set(triangulation_section.edge_previous, -3));
+
+    // unchanged bytes are accepted
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+    out.close();
+    snapshot s(path);
+    ASSERT_EQ(s.triangulation().vertex_count(), del.triangulation().vertex_count());
+    std::remove(path.c_str());
+}
+
 TEST(largest_empty_circle, circle_and_candidates) 
 {
     auto check_circle_and_candidates = [](std::vector<util::point> points, int expected_candidate_size, const util::circle& expected_largest_circle) {
@@ -957,6 +1935,9 @@ TEST(largest_empty_circle, circle_and_candidates)
         auto largest_circle = lec.get_largest_circle();
         ASSERT_EQ(candidates.size(), expected_candidate_size);
         ASSERT_EQ(largest_circle, expected_largest_circle);
+
+        largest_empty_circle clipped_lec(del.triangulation(), vor.graph(), clipped_voronoi{del.triangulation(), vor});
+        ASSERT_EQ(clipped_lec.get_largest_circle(), expected_largest_circle);
     };
 
     check_circle_and_candidates(